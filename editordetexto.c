@@ -1,171 +1,2097 @@
+// Compilar com: gcc editordetexto.c -o editordetexto -pthread
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <regex.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-#define MAX_LINES 1000      // Limite de linhas no texto
-#define MAX_LINE_LENGTH 256 // Máximo de caracteres por linha
-#define UNDO_REDO_DEPTH 100 // Máximo de operações armazenadas para undo/redo
+#define UNDO_MEMORY_BUDGET (16 * 1024 * 1024) // Memória padrão do histórico de undo/redo (bytes)
+#define INDEX_CHUNK (4 * 1024 * 1024)         // Bytes indexados por vez pela thread de indexação
+#define SAVE_IOV_BATCH 1024                   // Segmentos por chamada a writev ao salvar
+#define SAVE_STAGE_SIZE (256 * 1024)          // Área onde segmentos curtos são agrupados
+#define SAVE_COALESCE 512                     // Segmentos menores que isso são copiados
+#define SEARCH_PRINT_LIMIT 100                // Linhas exibidas por "buscar todas"
+#define ARENA_CHUNK (256 * 1024)              // Tamanho dos blocos da arena de linhas
+#define AUTOSAVE_INTERVAL_MS 1000             // Intervalo máximo entre gravações do journal
+#define AUTOSAVE_FLUSH_BYTES (1024 * 1024)    // Grava antes do intervalo ao acumular isso
+#define VIEW_DEFAULT_ROWS 24                  // Tamanho da tela quando não é um terminal
+#define VIEW_DEFAULT_COLS 80
 
-// Estrutura básica para armazenar o texto como array de linhas
+// Índice compacto de linhas: guarda só os 32 bits baixos de cada offset
+// (4 bytes por linha). A parte alta é reconstruída a partir de wraps, que
+// registra as (raras) entradas em que o offset cruza um múltiplo de 4 GB.
 typedef struct {
-    char *lines[MAX_LINES];
-    int line_count;
+    uint32_t *lo;
+    size_t count;
+    size_t cap;
+    size_t *wraps;   // wraps[j] = primeira entrada com offset >= (j+1) * 4 GB
+    size_t nwraps;
+    size_t wraps_cap;
+} LineIndex;
+
+// Arquivo carregado por mmap. O índice com o início de cada linha é montado
+// por uma thread em segundo plano, e quem precisa da linha k espera apenas
+// até ela ser indexada; por isso abrir o arquivo custa o mesmo para qualquer tamanho.
+typedef struct {
+    const char *data;
+    size_t size;
+    LineIndex index;    // entrada k = início da linha k; entrada k+1 = seu fim
+    size_t lines;       // linhas indexadas até agora
+    int done;           // índice completo
+    int cancel;         // pede à thread para parar (arquivo sendo fechado)
+    pthread_mutex_t lock;
+    pthread_cond_t progress;
+    pthread_t thread;
+} MappedFile;
+
+// Bloco de memória da arena de linhas
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size; // bytes disponíveis em data
+    size_t used;
+    char data[];
+} ArenaChunk;
+
+// Arena de alocação sequencial: nós e textos das linhas saem daqui sem um
+// malloc por linha, e tudo é liberado de uma vez. Ao recarregar, os blocos
+// são reaproveitados, então cargas seguidas não alocam nada.
+typedef struct {
+    ArenaChunk *head;
+    ArenaChunk *current; // bloco em uso; os seguintes estão vazios
+    size_t used;         // bytes entregues desde a última carga
+} Arena;
+
+// Entrada da tabela de linhas internadas (endereçamento aberto)
+typedef struct {
+    uint64_t hash;
+    const char *text; // NULL = posição livre
+    size_t len;
+} InternEntry;
+
+// Linhas iguais (em branco, repetidas) são guardadas uma única vez e
+// compartilhadas pelos nós. Os textos são imutáveis: editar uma linha
+// aponta o nó para outro texto (cópia na escrita).
+typedef struct {
+    InternEntry *slots;
+    size_t cap;   // potência de 2
+    size_t count;
+} InternTable;
+
+// Nó da rope de linhas: uma treap implícita, em que a posição de cada linha
+// é dada pelo tamanho das subárvores, e não por uma chave armazenada.
+// Inserção, edição e remoção custam O(log n) e não há limite de linhas
+// nem de tamanho de linha. Um nó guarda uma linha própria (text, internada)
+// ou um trecho de linhas ainda não materializadas do arquivo mapeado.
+typedef struct LineNode {
+    struct LineNode *left, *right;
+    unsigned int priority; // prioridade aleatória que mantém a árvore balanceada
+    size_t size;           // número de linhas na subárvore
+    size_t count;          // linhas deste nó (1 quando tem texto próprio)
+    size_t first;          // primeira linha do arquivo mapeado (quando text == NULL)
+    size_t len;
+    const char *text;
+} LineNode;
+
+// Journal de autosave: registros das edições acrescentados a <arquivo>.journal.
+// As edições só copiam o registro para buf; uma thread grava os lotes e faz
+// fsync periodicamente. Depois de uma queda, o journal é reaplicado sobre a
+// última versão salva do arquivo (identificada por tamanho e mtime no cabeçalho).
+typedef struct Journal {
+    int fd;
+    char *path;
+    char *buf;      // registros ainda não gravados
+    size_t len, cap;
+    int stop;
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t thread;
+} Journal;
+
+// Estrutura básica para armazenar o texto como sequência de linhas.
+// Com pending ativo, o texto é exatamente o arquivo mapeado e a árvore
+// ainda não foi montada: leituras vão direto ao índice do arquivo.
+typedef struct {
+    LineNode *root;
+    MappedFile *src;   // arquivo mapeado de onde vêm os trechos, se houver
+    int pending;
+    unsigned int seed; // estado do gerador das prioridades (por buffer)
+    Arena arena;       // nós e textos das linhas
+    InternTable intern;
+    LineNode *free_nodes; // nós removidos, para reuso
+    size_t garbage;       // bytes de textos substituídos que seguem na arena
+    Journal *journal;     // autosave das edições, quando associado a um arquivo
 } TextBuffer;
 
-// Estrutura para armazenar estado do texto para undo/redo
-typedef struct {
-    TextBuffer states[UNDO_REDO_DEPTH];
-    int top;       // posição atual para undo/redo
-    int max_state; // número máximo de estados salvo
-} UndoRedoStack;
+// Tipos de operação registrados no histórico de undo/redo
+typedef enum { OP_INSERT, OP_EDIT, OP_REMOVE } EditOpType;
+
+// Operação de edição com o necessário para refazê-la e desfazê-la
+typedef struct {
+    EditOpType type;
+    long index;     // linha afetada (1-based)
+    char *old_text; // texto antes da operação (edit/remove)
+    char *new_text; // texto depois da operação (insert/edit)
+    size_t bytes;   // memória ocupada pela operação
+    int chained;    // desfeita/refeita junto com a operação anterior (lote)
+} EditOp;
+
+// Histórico de undo/redo: log de operações em buffer circular. As operações
+// em [0, cursor) estão aplicadas e as em [cursor, count) podem ser refeitas.
+// A profundidade é limitada pela memória (budget), não por número de estados.
+typedef struct {
+    EditOp *ops;
+    size_t capacity;
+    size_t head;   // posição da operação mais antiga no buffer
+    size_t count;  // operações armazenadas
+    size_t cursor; // operações aplicadas
+    size_t bytes;  // memória usada pelas operações
+    size_t budget; // memória máxima do histórico
+} UndoRedoStack;
+
+// Lista de posições encontradas pelo scanner de quebras de linha
+typedef struct {
+    size_t *pos;
+    size_t n;
+    size_t cap;
+} PosList;
+
+static void pos_reserve(PosList *list, size_t extra) {
+    if (list->n + extra <= list->cap) return;
+    size_t cap = list->cap ? list->cap * 2 : 4096;
+    while (cap < list->n + extra) cap *= 2;
+    size_t *pos = (size_t*) realloc(list->pos, cap * sizeof(size_t));
+    if (!pos) {
+        printf("Erro ao alocar memória para o índice de linhas.\n");
+        exit(EXIT_FAILURE);
+    }
+    list->pos = pos;
+    list->cap = cap;
+}
+
+// Acrescenta em out o fim (posição após o \n) de cada linha terminada em
+// data[start, end). \r\n é tratado na leitura da linha, então basta o \n.
+static void scan_newlines_scalar(const char *data, size_t start, size_t end, PosList *out) {
+    const char *p = data + start, *limit = data + end;
+    while (p < limit) {
+        const char *nl = memchr(p, '\n', (size_t) (limit - p));
+        if (!nl) break;
+        pos_reserve(out, 1);
+        out->pos[out->n++] = (size_t) (nl - data) + 1;
+        p = nl + 1;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Extrai as posições dos bits ligados de mask (um bit por byte a partir de base)
+#define EMIT_MASK(out, mask, base)                                      \
+    while (mask) {                                                      \
+        (out)->pos[(out)->n++] = (base) + (size_t) __builtin_ctzll(mask) + 1; \
+        mask &= mask - 1;                                               \
+    }
+
+__attribute__((target("sse2")))
+static void scan_newlines_sse2(const char *data, size_t start, size_t end, PosList *out) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t i = start;
+    for (; i + 16 <= end; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (data + i));
+        unsigned long long mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        if (!mask) continue;
+        pos_reserve(out, 16);
+        EMIT_MASK(out, mask, i);
+    }
+    scan_newlines_scalar(data, i, end, out);
+}
+
+// Processa 64 bytes por iteração: duas comparações de 32 bytes viram uma máscara de 64 bits
+__attribute__((target("avx2")))
+static void scan_newlines_avx2(const char *data, size_t start, size_t end, PosList *out) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t i = start;
+    for (; i + 64 <= end; i += 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i*) (data + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (data + i + 32));
+        unsigned long long lo = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, nl));
+        unsigned long long hi = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, nl));
+        unsigned long long mask = lo | (hi << 32);
+        if (!mask) continue;
+        pos_reserve(out, 64);
+        EMIT_MASK(out, mask, i);
+    }
+    scan_newlines_sse2(data, i, end, out);
+}
+#endif
+
+typedef void (*ScanFn)(const char *data, size_t start, size_t end, PosList *out);
+
+// Escolhe o scanner mais rápido suportado pela CPU
+static ScanFn select_scanner(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return scan_newlines_avx2;
+    if (__builtin_cpu_supports("sse2")) return scan_newlines_sse2;
+#endif
+    return scan_newlines_scalar;
+}
+
+// Acrescenta um offset ao índice (offsets chegam em ordem crescente)
+static void index_push(LineIndex *ix, size_t off) {
+    if (ix->count == ix->cap) {
+        size_t cap = ix->cap ? ix->cap * 2 : 1024;
+        uint32_t *lo = (uint32_t*) realloc(ix->lo, cap * sizeof(uint32_t));
+        if (!lo) {
+            printf("Erro ao alocar memória para o índice de linhas.\n");
+            exit(EXIT_FAILURE);
+        }
+        ix->lo = lo;
+        ix->cap = cap;
+    }
+    while ((uint64_t) ix->nwraps < ((uint64_t) off >> 32)) {
+        if (ix->nwraps == ix->wraps_cap) {
+            ix->wraps_cap = ix->wraps_cap ? ix->wraps_cap * 2 : 8;
+            ix->wraps = (size_t*) realloc(ix->wraps, ix->wraps_cap * sizeof(size_t));
+            if (!ix->wraps) {
+                printf("Erro ao alocar memória para o índice de linhas.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        ix->wraps[ix->nwraps++] = ix->count;
+    }
+    ix->lo[ix->count++] = (uint32_t) off;
+}
+
+// Offset da entrada k; a busca em wraps só percorre um item a cada 4 GB de arquivo
+static size_t index_get(const LineIndex *ix, size_t k) {
+    uint64_t high = 0;
+    while (high < ix->nwraps && ix->wraps[high] <= k) high++;
+    return (size_t) ((high << 32) | ix->lo[k]);
+}
+
+static void free_line_index(LineIndex *ix) {
+    free(ix->lo);
+    free(ix->wraps);
+    memset(ix, 0, sizeof(*ix));
+}
+
+// Thread que monta o índice de linhas, publicando-o a cada INDEX_CHUNK bytes
+static void* index_thread(void *arg) {
+    MappedFile *mf = (MappedFile*) arg;
+    ScanFn scan = select_scanner();
+    PosList local = {NULL, 0, 0};
+    size_t pos = 0;
+
+    while (pos < mf->size) {
+        size_t end = pos + INDEX_CHUNK < mf->size ? pos + INDEX_CHUNK : mf->size;
+        local.n = 0;
+        scan(mf->data, pos, end, &local);
+        pos = end;
+
+        pthread_mutex_lock(&mf->lock);
+        // Cada \n fecha a linha corrente: a entrada k+1 é sempre o fim da linha k
+        for (size_t i = 0; i < local.n; i++) {
+            index_push(&mf->index, local.pos[i]);
+        }
+        mf->lines += local.n;
+        int stop = mf->cancel;
+        pthread_cond_broadcast(&mf->progress);
+        pthread_mutex_unlock(&mf->lock);
+        if (stop) break;
+    }
+
+    // Daqui em diante o acesso é aleatório (visualização, busca, edições):
+    // com SEQUENTIAL o kernel descartaria as páginas cedo demais
+    if (mf->size > 0) madvise((void*) mf->data, mf->size, MADV_NORMAL);
+
+    pthread_mutex_lock(&mf->lock);
+    // Última linha sem \n no final do arquivo
+    if (mf->size > 0 && mf->data[mf->size - 1] != '\n' && !mf->cancel) {
+        index_push(&mf->index, mf->size);
+        mf->lines++;
+    }
+    mf->done = 1;
+    pthread_cond_broadcast(&mf->progress);
+    pthread_mutex_unlock(&mf->lock);
+    free(local.pos);
+    return NULL;
+}
+
+// Mapeia o arquivo e dispara a indexação; retorna NULL se não for possível
+// usar mmap (arquivo especial, pipe etc.)
+static MappedFile* open_mapped_file(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return NULL;
+
+    MappedFile *mf = (MappedFile*) calloc(1, sizeof(MappedFile));
+    if (!mf) return NULL;
+    mf->size = (size_t) st.st_size;
+    if (mf->size > 0) {
+        void *data = mmap(NULL, mf->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            free(mf);
+            return NULL;
+        }
+        madvise(data, mf->size, MADV_SEQUENTIAL); // só durante a indexação
+        mf->data = (const char*) data;
+    }
+    index_push(&mf->index, 0); // início da primeira linha
+    pthread_mutex_init(&mf->lock, NULL);
+    pthread_cond_init(&mf->progress, NULL);
+    if (pthread_create(&mf->thread, NULL, index_thread, mf) != 0) {
+        printf("Erro ao criar thread de indexação.\n");
+        exit(EXIT_FAILURE);
+    }
+    return mf;
+}
+
+static void close_mapped_file(MappedFile *mf) {
+    if (!mf) return;
+    pthread_mutex_lock(&mf->lock);
+    mf->cancel = 1;
+    pthread_mutex_unlock(&mf->lock);
+    pthread_join(mf->thread, NULL);
+    if (mf->size > 0) munmap((void*) mf->data, mf->size);
+    pthread_mutex_destroy(&mf->lock);
+    pthread_cond_destroy(&mf->progress);
+    free_line_index(&mf->index);
+    free(mf);
+}
+
+// Localiza a linha k (0-based) do arquivo, esperando a indexação chegar
+// até ela. Retorna 0 se o arquivo tem menos de k+1 linhas.
+static int mapped_line(MappedFile *mf, size_t k, const char **line, size_t *len) {
+    pthread_mutex_lock(&mf->lock);
+    while (k >= mf->lines && !mf->done) {
+        pthread_cond_wait(&mf->progress, &mf->lock);
+    }
+    if (k >= mf->lines) {
+        pthread_mutex_unlock(&mf->lock);
+        return 0;
+    }
+    size_t start = index_get(&mf->index, k);
+    size_t end = index_get(&mf->index, k + 1);
+    pthread_mutex_unlock(&mf->lock);
+
+    if (end > start && mf->data[end - 1] == '\n') end--; // remove \n
+    if (end > start && mf->data[end - 1] == '\r') end--; // e \r de \r\n
+    *line = mf->data + start;
+    *len = end - start;
+    return 1;
+}
+
+// Número total de linhas do arquivo (espera a indexação terminar)
+static size_t mapped_line_total(MappedFile *mf) {
+    pthread_mutex_lock(&mf->lock);
+    while (!mf->done) {
+        pthread_cond_wait(&mf->progress, &mf->lock);
+    }
+    size_t total = mf->lines;
+    pthread_mutex_unlock(&mf->lock);
+    return total;
+}
+
+// Gerador xorshift para as prioridades dos nós
+static unsigned int next_priority(TextBuffer *txt) {
+    unsigned int x = txt->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    txt->seed = x;
+    return x;
+}
+
+static size_t node_size(LineNode *n) {
+    return n ? n->size : 0;
+}
+
+static void update_size(LineNode *n) {
+    n->size = n->count + node_size(n->left) + node_size(n->right);
+}
+
+static ArenaChunk* new_arena_chunk(size_t size) {
+    ArenaChunk *c = (ArenaChunk*) malloc(sizeof(ArenaChunk) + size);
+    if (!c) {
+        printf("Erro ao alocar memória para linha.\n");
+        exit(EXIT_FAILURE);
+    }
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+static void* arena_alloc(Arena *a, size_t size) {
+    size = (size + 15) & ~(size_t) 15;
+    a->used += size;
+    if (!a->current) {
+        a->head = a->current = new_arena_chunk(ARENA_CHUNK);
+    }
+    if (size > ARENA_CHUNK / 4) {
+        // Alocação grande: bloco próprio logo após o atual
+        ArenaChunk *c = new_arena_chunk(size);
+        c->used = size;
+        c->next = a->current->next;
+        a->current->next = c;
+        return c->data;
+    }
+    while (a->current->used + size > a->current->size) {
+        if (!a->current->next) a->current->next = new_arena_chunk(ARENA_CHUNK);
+        a->current = a->current->next;
+    }
+    void *p = a->current->data + a->current->used;
+    a->current->used += size;
+    return p;
+}
+
+// Esvazia a arena mantendo os blocos de tamanho padrão para reuso
+static void arena_reset(Arena *a) {
+    ArenaChunk **link = &a->head;
+    while (*link) {
+        ArenaChunk *c = *link;
+        if (c->size > ARENA_CHUNK) {
+            *link = c->next;
+            free(c);
+        } else {
+            c->used = 0;
+            link = &c->next;
+        }
+    }
+    a->current = a->head;
+    a->used = 0;
+}
+
+static void arena_free(Arena *a) {
+    while (a->head) {
+        ArenaChunk *next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+    a->current = NULL;
+    a->used = 0;
+}
+
+// FNV-1a de 64 bits
+static uint64_t hash_text(const char *s, size_t len) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) s[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static void intern_grow(InternTable *t) {
+    size_t cap = t->cap ? t->cap * 2 : 1024;
+    InternEntry *slots = (InternEntry*) calloc(cap, sizeof(InternEntry));
+    if (!slots) {
+        printf("Erro ao alocar memória para linha.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < t->cap; i++) {
+        if (!t->slots[i].text) continue;
+        size_t j = t->slots[i].hash & (cap - 1);
+        while (slots[j].text) j = (j + 1) & (cap - 1);
+        slots[j] = t->slots[i];
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->cap = cap;
+}
+
+// Retorna o texto internado igual a line[0, len), copiando-o para a arena
+// na primeira vez; o resultado termina em '\0' e não deve ser alterado
+static const char* intern_text(TextBuffer *txt, const char *line, size_t len) {
+    InternTable *t = &txt->intern;
+    if ((t->count + 1) * 10 > t->cap * 7) intern_grow(t);
+    uint64_t h = hash_text(line, len);
+    size_t j = h & (t->cap - 1);
+    while (t->slots[j].text) {
+        InternEntry *e = &t->slots[j];
+        if (e->hash == h && e->len == len && memcmp(e->text, line, len) == 0) {
+            return e->text;
+        }
+        j = (j + 1) & (t->cap - 1);
+    }
+    char *text = (char*) arena_alloc(&txt->arena, len + 1);
+    memcpy(text, line, len);
+    text[len] = '\0';
+    t->slots[j].hash = h;
+    t->slots[j].text = text;
+    t->slots[j].len = len;
+    t->count++;
+    return text;
+}
+
+static LineNode* alloc_line_node(TextBuffer *txt) {
+    LineNode *n = txt->free_nodes;
+    if (n) {
+        txt->free_nodes = n->left;
+    } else {
+        n = (LineNode*) arena_alloc(&txt->arena, sizeof(LineNode));
+    }
+    n->left = n->right = NULL;
+    n->priority = next_priority(txt);
+    n->size = n->count = 1;
+    n->first = 0;
+    n->len = 0;
+    n->text = NULL;
+    return n;
+}
+
+// Aponta o nó para o texto internado da linha (materializa a linha)
+static void set_node_text(TextBuffer *txt, LineNode *n, const char *line, size_t len) {
+    n->text = intern_text(txt, line, len);
+    n->len = len;
+}
+
+// Cria um nó com o texto informado
+static LineNode* new_line_node(TextBuffer *txt, const char *line, size_t len) {
+    LineNode *n = alloc_line_node(txt);
+    set_node_text(txt, n, line, len);
+    return n;
+}
+
+// Cria um nó que representa count linhas do arquivo mapeado a partir de first
+static LineNode* new_piece_node(TextBuffer *txt, size_t first, size_t count) {
+    LineNode *n = alloc_line_node(txt);
+    n->first = first;
+    n->count = count;
+    n->size = count;
+    return n;
+}
+
+// Devolve os nós da subárvore para a lista de reuso (os textos ficam na
+// arena até a próxima compactação, pois podem ser compartilhados)
+static void free_tree(TextBuffer *txt, LineNode *n) {
+    if (!n) return;
+    free_tree(txt, n->left);
+    free_tree(txt, n->right);
+    if (n->text) txt->garbage += n->len + 1;
+    n->left = txt->free_nodes;
+    txt->free_nodes = n;
+}
+
+// Copia a subárvore para a arena atual, internando de novo os textos
+static LineNode* copy_tree(TextBuffer *txt, const LineNode *n) {
+    if (!n) return NULL;
+    LineNode *c = (LineNode*) arena_alloc(&txt->arena, sizeof(LineNode));
+    *c = *n;
+    if (n->text) c->text = intern_text(txt, n->text, n->len);
+    c->left = copy_tree(txt, n->left);
+    c->right = copy_tree(txt, n->right);
+    return c;
+}
+
+// Recupera a memória dos textos substituídos por edições: copia os nós e
+// textos ainda em uso para uma arena nova e libera a antiga. O histórico
+// de undo guarda cópias próprias, então nada fora da árvore aponta para
+// a arena antiga.
+static void compact_text_buffer(TextBuffer *txt) {
+    Arena old = txt->arena;
+    InternTable old_intern = txt->intern;
+    memset(&txt->arena, 0, sizeof(txt->arena));
+    memset(&txt->intern, 0, sizeof(txt->intern));
+    txt->free_nodes = NULL;
+    txt->root = copy_tree(txt, txt->root);
+    arena_free(&old);
+    free(old_intern.slots);
+    txt->garbage = 0;
+}
+
+// Compacta quando o lixo passa de um bloco e de metade da arena, de modo
+// que o custo da cópia se dilui nas edições que o geraram
+static void maybe_compact(TextBuffer *txt) {
+    if (txt->garbage >= ARENA_CHUNK && txt->garbage * 2 >= txt->arena.used) {
+        compact_text_buffer(txt);
+    }
+}
+
+static LineNode* merge_tree(LineNode *l, LineNode *r);
+
+// Separa a árvore t em l (primeiras k linhas) e r (restante). Um trecho do
+// arquivo que contenha a fronteira é dividido em dois nós.
+static void split_tree(TextBuffer *txt, LineNode *t, size_t k, LineNode **l, LineNode **r) {
+    if (!t) {
+        *l = *r = NULL;
+        return;
+    }
+    size_t ls = node_size(t->left);
+    if (k > ls && k < ls + t->count) {
+        size_t head = k - ls;
+        LineNode *rest = new_piece_node(txt, t->first + head, t->count - head);
+        t->count = head;
+        *r = merge_tree(rest, t->right);
+        t->right = NULL;
+        *l = t;
+    } else if (k >= ls + t->count) {
+        split_tree(txt, t->right, k - ls - t->count, &t->right, r);
+        *l = t;
+    } else {
+        split_tree(txt, t->left, k, l, &t->left);
+        *r = t;
+    }
+    update_size(t);
+}
+
+// Concatena l e r (todas as linhas de l vêm antes das de r)
+static LineNode* merge_tree(LineNode *l, LineNode *r) {
+    if (!l) return r;
+    if (!r) return l;
+    if (l->priority > r->priority) {
+        l->right = merge_tree(l->right, r);
+        update_size(l);
+        return l;
+    }
+    r->left = merge_tree(l, r->left);
+    update_size(r);
+    return r;
+}
+
+// Retorna o nó que contém a linha idx (0-based) e a posição dela no nó
+static LineNode* find_line(LineNode *t, size_t idx, size_t *offset) {
+    while (t) {
+        size_t ls = node_size(t->left);
+        if (idx < ls) {
+            t = t->left;
+        } else if (idx < ls + t->count) {
+            *offset = idx - ls;
+            return t;
+        } else {
+            idx -= ls + t->count;
+            t = t->right;
+        }
+    }
+    return NULL;
+}
+
+// Monta a árvore a partir do arquivo mapeado antes da primeira edição:
+// um único nó com todas as linhas, dividido conforme as edições o tocam
+static void ensure_tree(TextBuffer *txt) {
+    if (!txt->pending) return;
+    // Espera a indexação terminar: a primeira edição de um arquivo grande
+    // bloqueia até o índice estar completo
+    size_t total = mapped_line_total(txt->src);
+    txt->root = total ? new_piece_node(txt, 0, total) : NULL;
+    txt->pending = 0;
+}
+
+// Número de linhas do buffer
+size_t line_count(TextBuffer *txt) {
+    ensure_tree(txt);
+    return node_size(txt->root);
+}
+
+// Texto da linha (1-based) e seu tamanho, ou NULL se o índice não existir.
+// Linhas do arquivo mapeado não terminam em '\0'.
+const char* get_line(TextBuffer *txt, long index, size_t *len) {
+    const char *line;
+    if (index < 1) return NULL;
+    if (txt->pending) {
+        return mapped_line(txt->src, (size_t) index - 1, &line, len) ? line : NULL;
+    }
+    size_t off;
+    LineNode *n = find_line(txt->root, (size_t) index - 1, &off);
+    if (!n) return NULL;
+    if (n->text) {
+        *len = n->len;
+        return n->text;
+    }
+    mapped_line(txt->src, n->first + off, &line, len);
+    return line;
+}
+
+// Acrescenta uma linha ao final do buffer
+void append_line(TextBuffer *txt, const char *line, size_t len) {
+    ensure_tree(txt);
+    txt->root = merge_tree(txt->root, new_line_node(txt, line, len));
+}
+
+// Inicializa o buffer de texto vazio; a memória cresce com o conteúdo
+void init_text_buffer(TextBuffer *txt) {
+    memset(txt, 0, sizeof(*txt));
+    txt->seed = 2463534242u;
+}
+
+// Esvazia o buffer de uma vez só: fecha o arquivo mapeado e zera a arena
+// e a tabela de linhas, mantendo a memória já alocada para reuso
+void reset_text_buffer(TextBuffer *txt) {
+    txt->root = NULL;
+    txt->free_nodes = NULL;
+    txt->garbage = 0;
+    close_mapped_file(txt->src);
+    txt->src = NULL;
+    txt->pending = 0;
+    arena_reset(&txt->arena);
+    if (txt->intern.count > 0) {
+        memset(txt->intern.slots, 0, txt->intern.cap * sizeof(InternEntry));
+        txt->intern.count = 0;
+    }
+}
+
+// Libera toda a memória do buffer, deixando-o vazio
+void free_text_buffer(TextBuffer *txt) {
+    reset_text_buffer(txt);
+    arena_free(&txt->arena);
+    free(txt->intern.slots);
+    txt->intern.slots = NULL;
+    txt->intern.cap = 0;
+}
+
+// Carrega arquivo para buffer de texto. Arquivos regulares são mapeados e
+// as linhas só são lidas quando exibidas ou editadas; os demais (pipes etc.)
+// são lidos linha a linha, sem limite de tamanho.
+int load_file(const char *filename, TextBuffer *txt) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Não foi possível abrir o arquivo %s para leitura.\n", filename);
+        return 0;
+    }
+    reset_text_buffer(txt);
+
+    MappedFile *mf = open_mapped_file(fd);
+    if (mf) {
+        close(fd); // o mapeamento continua válido sem o descritor
+        txt->src = mf;
+        txt->pending = 1;
+        return 1;
+    }
+
+    FILE *file = fdopen(fd, "r");
+    if (!file) {
+        close(fd);
+        printf("Não foi possível abrir o arquivo %s para leitura.\n", filename);
+        return 0;
+    }
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &cap, file)) != -1) {
+        len = (ssize_t) strcspn(line, "\r\n"); // remove \n ou \r\n
+        append_line(txt, line, (size_t) len);
+    }
+    free(line);
+    fclose(file);
+    return 1;
+}
+
+// Acumula segmentos de linhas para gravá-los com writev em lotes grandes.
+// Segmentos curtos são copiados para stage (um iovec por linha custaria
+// mais que a cópia); os longos são referenciados sem cópia.
+typedef struct {
+    int fd;
+    struct iovec iov[SAVE_IOV_BATCH];
+    int n;
+    int error;
+    size_t bytes; // total gravado
+    size_t staged;
+    char stage[SAVE_STAGE_SIZE];
+} IovWriter;
+
+// Grava todos os segmentos pendentes, tratando escritas parciais
+static void iov_flush(IovWriter *w) {
+    struct iovec *iov = w->iov;
+    int n = w->n;
+    while (n > 0 && !w->error) {
+        ssize_t written = writev(w->fd, iov, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            w->error = 1;
+            break;
+        }
+        w->bytes += (size_t) written;
+        while (n > 0 && (size_t) written >= iov->iov_len) {
+            written -= (ssize_t) iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char*) iov->iov_base + written;
+            iov->iov_len -= (size_t) written;
+        }
+    }
+    w->n = 0;
+    w->staged = 0;
+}
+
+static void iov_add(IovWriter *w, const char *data, size_t len) {
+    if (len == 0) return;
+    if (len < SAVE_COALESCE) {
+        if (w->staged + len > SAVE_STAGE_SIZE) iov_flush(w);
+        char *dst = w->stage + w->staged;
+        memcpy(dst, data, len);
+        w->staged += len;
+        struct iovec *last = w->n ? &w->iov[w->n - 1] : NULL;
+        if (last && (char*) last->iov_base + last->iov_len == dst) {
+            last->iov_len += len; // continua o trecho copiado anterior
+            return;
+        }
+        data = dst;
+    }
+    if (w->n == SAVE_IOV_BATCH) {
+        // Os dados copiados neste momento ficam no stage após o flush
+        int staged_now = data >= w->stage && data < w->stage + SAVE_STAGE_SIZE;
+        iov_flush(w);
+        if (staged_now) {
+            memmove(w->stage, data, len);
+            data = w->stage;
+            w->staged = len;
+        }
+    }
+    w->iov[w->n].iov_base = (void*) data;
+    w->iov[w->n].iov_len = len;
+    w->n++;
+}
+
+// Grava as linhas [first, first+count) do arquivo mapeado. Sem \r no trecho,
+// os bytes no arquivo já são as linhas terminadas em \n: um único segmento.
+static void write_piece(IovWriter *w, MappedFile *mf, size_t first, size_t count) {
+    const char *line;
+    size_t len;
+    if (!mapped_line(mf, first, &line, &len)) return;
+    size_t start = (size_t) (line - mf->data);
+    size_t end = index_get(&mf->index, first + count);
+    if (!memchr(mf->data + start, '\r', end - start)) {
+        iov_add(w, mf->data + start, end - start);
+        if (mf->data[end - 1] != '\n') iov_add(w, "\n", 1); // última linha sem \n
+        return;
+    }
+    for (size_t k = first; k < first + count; k++) {
+        mapped_line(mf, k, &line, &len);
+        iov_add(w, line, len);
+        iov_add(w, "\n", 1);
+    }
+}
+
+// Grava as linhas da subárvore em ordem
+static void write_tree(IovWriter *w, MappedFile *mf, LineNode *n) {
+    if (!n) return;
+    write_tree(w, mf, n->left);
+    if (n->text) {
+        iov_add(w, n->text, n->len);
+        iov_add(w, "\n", 1);
+    } else {
+        write_piece(w, mf, n->first, n->count);
+    }
+    write_tree(w, mf, n->right);
+}
+
+// Sincroniza o diretório que contém path, tornando o rename durável
+static void fsync_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    char *dir = slash ? strndup(path, slash == path ? 1 : (size_t) (slash - path)) : strdup(".");
+    if (!dir) return;
+    int dfd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+    free(dir);
+}
+
+// Salva o buffer de texto no arquivo de forma atômica: grava tudo em um
+// temporário no mesmo diretório com writev, faz fsync e o renomeia sobre o
+// destino. Uma falha no meio do caminho deixa o arquivo original intacto
+// (inclusive o arquivo mapeado de onde as linhas ainda são lidas).
+int save_file(const char *filename, TextBuffer *txt) {
+    static unsigned int tmp_counter = 0;
+    char *real = realpath(filename, NULL); // grava no alvo de links simbólicos
+    const char *target = real ? real : filename;
+    size_t tmp_size = strlen(target) + 64;
+    char *tmpname = (char*) malloc(tmp_size);
+    if (!tmpname) {
+        free(real);
+        printf("Erro ao alocar memória para salvar o arquivo.\n");
+        return 0;
+    }
+
+    int fd;
+    do {
+        unsigned int id = __atomic_fetch_add(&tmp_counter, 1, __ATOMIC_RELAXED);
+        snprintf(tmpname, tmp_size, "%s.tmp.%ld.%u", target, (long) getpid(), id);
+        fd = open(tmpname, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    } while (fd < 0 && errno == EEXIST);
+    if (fd < 0) {
+        printf("Não foi possível abrir o arquivo %s para escrita.\n", filename);
+        free(tmpname);
+        free(real);
+        return 0;
+    }
+    struct stat st;
+    if (stat(target, &st) == 0) fchmod(fd, st.st_mode & 07777); // mantém as permissões
+
+    ensure_tree(txt);
+    IovWriter *w = (IovWriter*) malloc(sizeof(IovWriter));
+    int ok = w != NULL;
+    if (ok) {
+        w->fd = fd;
+        w->n = 0;
+        w->error = 0;
+        w->bytes = 0;
+        w->staged = 0;
+        write_tree(w, txt->src, txt->root);
+        iov_flush(w);
+        ok = !w->error;
+    }
+    free(w);
+    if (ok) ok = fsync(fd) == 0;
+    if (close(fd) != 0) ok = 0;
+    if (ok) ok = rename(tmpname, target) == 0;
+    if (ok) {
+        fsync_parent_dir(target);
+        if (txt->garbage > 0) compact_text_buffer(txt); // devolve o lixo das edições
+    } else {
+        unlink(tmpname);
+        printf("Erro ao gravar o arquivo %s.\n", filename);
+    }
+    free(tmpname);
+    free(real);
+    return ok;
+}
+
+// Imprime as linhas da subárvore em ordem, numerando a partir de *num
+static void print_tree(MappedFile *mf, LineNode *n, size_t *num) {
+    if (!n) return;
+    print_tree(mf, n->left, num);
+    if (n->text) {
+        printf("%3zu: %s\n", ++*num, n->text);
+    } else {
+        for (size_t k = n->first; k < n->first + n->count; k++) {
+            const char *line;
+            size_t len;
+            mapped_line(mf, k, &line, &len);
+            printf("%3zu: %.*s\n", ++*num, (int) len, line);
+        }
+    }
+    print_tree(mf, n->right, num);
+}
+
+// Exibe o conteúdo atual do buffer com numeração de linhas. Um arquivo
+// recém-carregado é exibido à medida que é indexado.
+void display_text(TextBuffer *txt) {
+    size_t num = 0;
+    printf("\n=== Texto Atualmente ===\n");
+    if (txt->pending) {
+        const char *line;
+        size_t len;
+        while (mapped_line(txt->src, num, &line, &len)) {
+            printf("%3zu: %.*s\n", ++num, (int) len, line);
+        }
+    } else {
+        print_tree(txt->src, txt->root, &num);
+    }
+    printf("=======================\n");
+}
+
+// Grava todo o conteúdo, repetindo em escritas parciais
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += n;
+        len -= (size_t) n;
+    }
+    return 1;
+}
+
+// Thread do journal: espera registros, junta o que chegar em até
+// AUTOSAVE_INTERVAL_MS (ou AUTOSAVE_FLUSH_BYTES) e grava com um único fsync
+static void* journal_thread(void *arg) {
+    Journal *j = (Journal*) arg;
+    char *batch = NULL;
+    size_t batch_cap = 0;
+    pthread_mutex_lock(&j->lock);
+    for (;;) {
+        while (j->len == 0 && !j->stop) {
+            pthread_cond_wait(&j->wake, &j->lock);
+        }
+        if (!j->stop && j->len < AUTOSAVE_FLUSH_BYTES) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long) AUTOSAVE_INTERVAL_MS * 1000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            while (!j->stop && j->len < AUTOSAVE_FLUSH_BYTES &&
+                   pthread_cond_timedwait(&j->wake, &j->lock, &deadline) == 0) {
+            }
+        }
+        if (j->len == 0 && j->stop) break;
+
+        // Troca os buffers para gravar sem segurar o lock
+        char *data = j->buf;
+        size_t len = j->len, data_cap = j->cap;
+        j->buf = batch;
+        j->cap = batch_cap;
+        j->len = 0;
+        pthread_mutex_unlock(&j->lock);
+
+        int ok = !j->failed && write_all(j->fd, data, len) && fsync(j->fd) == 0;
+        batch = data;
+        batch_cap = data_cap;
+
+        pthread_mutex_lock(&j->lock);
+        if (!ok && !j->failed) {
+            j->failed = 1;
+            printf("Aviso: falha ao gravar o journal %s; autosave desativado.\n", j->path);
+        }
+    }
+    pthread_mutex_unlock(&j->lock);
+    free(batch);
+    return NULL;
+}
+
+static char* journal_path(const char *filename) {
+    size_t size = strlen(filename) + sizeof(".journal");
+    char *path = (char*) malloc(size);
+    if (path) snprintf(path, size, "%s.journal", filename);
+    return path;
+}
+
+// Cabeçalho do journal: identifica a versão do arquivo sobre a qual os
+// registros devem ser aplicados
+typedef struct {
+    char magic[4];
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+} JournalHeader;
+
+static void fill_journal_header(JournalHeader *h, const struct stat *st) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, "EDJ1", 4);
+    h->size = (uint64_t) st->st_size;
+    h->mtime_sec = (int64_t) st->st_mtim.tv_sec;
+    h->mtime_nsec = (int64_t) st->st_mtim.tv_nsec;
+}
+
+// Abre o journal de filename. Com keep, continua o journal existente (após
+// uma recuperação); senão começa um novo, com o estado atual do arquivo.
+Journal* open_journal(const char *filename, int keep) {
+    struct stat st;
+    if (stat(filename, &st) != 0) return NULL;
+    Journal *j = (Journal*) calloc(1, sizeof(Journal));
+    if (!j) return NULL;
+    j->path = journal_path(filename);
+    j->fd = j->path ? open(j->path, O_WRONLY | O_CREAT | (keep ? O_APPEND : O_TRUNC), 0600) : -1;
+    if (j->fd < 0) {
+        printf("Aviso: não foi possível criar o journal de autosave.\n");
+        free(j->path);
+        free(j);
+        return NULL;
+    }
+    if (!keep) {
+        JournalHeader h;
+        fill_journal_header(&h, &st);
+        if (!write_all(j->fd, (const char*) &h, sizeof(h)) || fsync(j->fd) != 0) {
+            j->failed = 1;
+        }
+    }
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->wake, NULL);
+    if (pthread_create(&j->thread, NULL, journal_thread, j) != 0) {
+        printf("Erro ao criar thread do journal.\n");
+        exit(EXIT_FAILURE);
+    }
+    return j;
+}
+
+// Grava o que falta e fecha o journal; com remove_file, apaga o arquivo
+// (as edições já estão salvas ou foram descartadas)
+void close_journal(Journal *j, int remove_file) {
+    if (!j) return;
+    pthread_mutex_lock(&j->lock);
+    j->stop = 1;
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+    pthread_join(j->thread, NULL);
+    close(j->fd);
+    if (remove_file) unlink(j->path);
+    pthread_mutex_destroy(&j->lock);
+    pthread_cond_destroy(&j->wake);
+    free(j->buf);
+    free(j->path);
+    free(j);
+}
+
+// Acrescenta um registro: tipo ('I', 'E' ou 'R'), índice, tamanho e texto
+static void journal_append(Journal *j, char type, long index, const char *text, size_t len) {
+    uint64_t idx = (uint64_t) index, size = (uint64_t) len;
+    size_t rec = 1 + 2 * sizeof(uint64_t) + len;
+    pthread_mutex_lock(&j->lock);
+    if (j->len + rec > j->cap) {
+        size_t cap = j->cap ? j->cap * 2 : 4096;
+        while (cap < j->len + rec) cap *= 2;
+        char *buf = (char*) realloc(j->buf, cap);
+        if (!buf) {
+            printf("Erro ao alocar memória para o journal.\n");
+            exit(EXIT_FAILURE);
+        }
+        j->buf = buf;
+        j->cap = cap;
+    }
+    char *p = j->buf + j->len;
+    *p++ = type;
+    memcpy(p, &idx, sizeof(idx));
+    p += sizeof(idx);
+    memcpy(p, &size, sizeof(size));
+    p += sizeof(size);
+    if (len > 0) memcpy(p, text, len);
+    j->len += rec;
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+}
+
+// Insere nova linha no índice informado (1-based), empurrando as linhas para baixo
+int insert_line(TextBuffer *txt, long index, const char *line) {
+    if (index < 1 || (size_t) index > line_count(txt) + 1) {
+        printf("Índice inválido para inserção.\n");
+        return 0;
+    }
+    LineNode *l, *r;
+    split_tree(txt, txt->root, (size_t) index - 1, &l, &r);
+    l = merge_tree(l, new_line_node(txt, line, strlen(line)));
+    txt->root = merge_tree(l, r);
+    if (txt->journal) journal_append(txt->journal, 'I', index, line, strlen(line));
+    return 1;
+}
+
+// Edita linha existente (1-based)
+int edit_line(TextBuffer *txt, long index, const char *line) {
+    if (index < 1 || (size_t) index > line_count(txt)) {
+        printf("Índice inválido para edição.\n");
+        return 0;
+    }
+    size_t off;
+    LineNode *n = find_line(txt->root, (size_t) index - 1, &off);
+    if (!n->text) {
+        // Linha ainda no arquivo mapeado: isola-a em um nó próprio
+        LineNode *l, *mid, *r;
+        split_tree(txt, txt->root, (size_t) index - 1, &l, &r);
+        split_tree(txt, r, 1, &mid, &r);
+        n = mid;
+        txt->root = merge_tree(merge_tree(l, mid), r);
+    } else {
+        txt->garbage += n->len + 1;
+    }
+    set_node_text(txt, n, line, strlen(line));
+    if (txt->journal) journal_append(txt->journal, 'E', index, line, strlen(line));
+    maybe_compact(txt);
+    return 1;
+}
+
+// Remove linha do índice informado (1-based), puxando linhas para cima
+int remove_line(TextBuffer *txt, long index) {
+    if (index < 1 || (size_t) index > line_count(txt)) {
+        printf("Índice inválido para remoção.\n");
+        return 0;
+    }
+    LineNode *l, *mid, *r;
+    split_tree(txt, txt->root, (size_t) index - 1, &l, &r);
+    split_tree(txt, r, 1, &mid, &r);
+    free_tree(txt, mid);
+    txt->root = merge_tree(l, r);
+    if (txt->journal) journal_append(txt->journal, 'R', index, NULL, 0);
+    maybe_compact(txt);
+    return 1;
+}
+
+// Lê o journal de filename, se existir e corresponder à versão atual do
+// arquivo. Retorna o conteúdo (registros após o cabeçalho) ou NULL.
+static char* read_journal(const char *filename, size_t *len) {
+    struct stat st, jst;
+    char *path = journal_path(filename);
+    int fd = path ? open(path, O_RDONLY) : -1;
+    free(path);
+    if (fd < 0) return NULL;
+    char *data = NULL;
+    JournalHeader h, expected;
+    if (stat(filename, &st) == 0 && fstat(fd, &jst) == 0 &&
+        (size_t) jst.st_size > sizeof(h) &&
+        read(fd, &h, sizeof(h)) == (ssize_t) sizeof(h)) {
+        fill_journal_header(&expected, &st);
+        if (memcmp(&h, &expected, sizeof(h)) == 0) {
+            *len = (size_t) jst.st_size - sizeof(h);
+            data = (char*) malloc(*len);
+            if (data && read(fd, data, *len) != (ssize_t) *len) {
+                free(data);
+                data = NULL;
+            }
+        }
+    }
+    close(fd);
+    return data;
+}
+
+// Indica se há edições não salvas de uma sessão anterior para filename
+int journal_pending(const char *filename) {
+    size_t len;
+    char *data = read_journal(filename, &len);
+    free(data);
+    return data != NULL;
+}
+
+// Reaplica o journal sobre o buffer (recém-carregado de filename). Um
+// registro incompleto no final (queda no meio da gravação) é ignorado.
+// Retorna o número de edições reaplicadas.
+size_t replay_journal(const char *filename, TextBuffer *txt) {
+    size_t len, applied = 0;
+    char *data = read_journal(filename, &len);
+    if (!data) return 0;
+    Journal *saved = txt->journal;
+    txt->journal = NULL; // a reaplicação não gera novos registros
+    char *text = NULL;
+    size_t pos = 0;
+    while (pos + 1 + 2 * sizeof(uint64_t) <= len) {
+        char type = data[pos];
+        uint64_t idx, size;
+        memcpy(&idx, data + pos + 1, sizeof(idx));
+        memcpy(&size, data + pos + 1 + sizeof(idx), sizeof(size));
+        size_t body = pos + 1 + 2 * sizeof(uint64_t);
+        if (size > len - body) break;
+        text = (char*) realloc(text, size + 1);
+        if (!text) {
+            printf("Erro ao alocar memória para o journal.\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(text, data + body, size);
+        text[size] = '\0';
+        int ok;
+        if (type == 'I') ok = insert_line(txt, (long) idx, text);
+        else if (type == 'E') ok = edit_line(txt, (long) idx, text);
+        else if (type == 'R') ok = remove_line(txt, (long) idx);
+        else ok = 0;
+        if (!ok) break;
+        applied++;
+        pos = body + size;
+    }
+    free(text);
+    free(data);
+    txt->journal = saved;
+    return applied;
+}
+
+// Inicializa o histórico de undo/redo com o limite de memória informado
+void init_undo_redo(UndoRedoStack *stack, size_t budget) {
+    stack->ops = NULL;
+    stack->capacity = 0;
+    stack->head = 0;
+    stack->count = 0;
+    stack->cursor = 0;
+    stack->bytes = 0;
+    stack->budget = budget;
+}
+
+static EditOp* op_at(UndoRedoStack *stack, size_t i) {
+    return &stack->ops[(stack->head + i) % stack->capacity];
+}
+
+static void free_op(UndoRedoStack *stack, EditOp *op) {
+    stack->bytes -= op->bytes;
+    free(op->old_text);
+    free(op->new_text);
+}
+
+// Descarta todas as operações (por exemplo, ao carregar outro arquivo)
+void clear_undo_redo(UndoRedoStack *stack) {
+    for (size_t i = 0; i < stack->count; i++) {
+        free_op(stack, op_at(stack, i));
+    }
+    stack->head = 0;
+    stack->count = 0;
+    stack->cursor = 0;
+}
+
+void free_undo_redo(UndoRedoStack *stack) {
+    clear_undo_redo(stack);
+    free(stack->ops);
+    stack->ops = NULL;
+    stack->capacity = 0;
+}
+
+static char* dup_text(const char *s, size_t len) {
+    if (!s) return NULL;
+    char *d = (char*) malloc(len + 1);
+    if (!d) {
+        printf("Erro ao alocar memória para histórico.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(d, s, len);
+    d[len] = '\0';
+    return d;
+}
+
+// Registra uma operação já aplicada: descarta o que podia ser refeito e,
+// se o limite de memória for excedido, descarta as operações mais antigas
+static void record_op(UndoRedoStack *stack, EditOpType type, long index,
+                      const char *old_text, const char *new_text, int chained) {
+    if (chained && stack->cursor == 0) return; // o início do lote já foi descartado
+    while (stack->count > stack->cursor) {
+        stack->count--;
+        free_op(stack, op_at(stack, stack->count));
+    }
+    if (stack->count == stack->capacity) {
+        // Cresce o buffer circular, deixando as operações em ordem a partir de 0
+        size_t new_cap = stack->capacity ? stack->capacity * 2 : 64;
+        EditOp *ops = (EditOp*) malloc(new_cap * sizeof(EditOp));
+        if (!ops) {
+            printf("Erro ao alocar memória para histórico.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < stack->count; i++) {
+            ops[i] = *op_at(stack, i);
+        }
+        free(stack->ops);
+        stack->ops = ops;
+        stack->capacity = new_cap;
+        stack->head = 0;
+    }
+    EditOp *op = op_at(stack, stack->count);
+    op->type = type;
+    op->index = index;
+    op->old_text = dup_text(old_text, old_text ? strlen(old_text) : 0);
+    op->new_text = dup_text(new_text, new_text ? strlen(new_text) : 0);
+    op->bytes = sizeof(EditOp) + (old_text ? strlen(old_text) + 1 : 0)
+                + (new_text ? strlen(new_text) + 1 : 0);
+    op->chained = chained;
+    stack->bytes += op->bytes;
+    stack->count++;
+    stack->cursor++;
+
+    // Um lote é descartado inteiro, para nunca ser desfeito pela metade
+    while (stack->count > 0 &&
+           (stack->bytes > stack->budget || op_at(stack, 0)->chained)) {
+        free_op(stack, op_at(stack, 0));
+        stack->head = (stack->head + 1) % stack->capacity;
+        stack->count--;
+        stack->cursor--;
+    }
+}
 
-// Inicializa o buffer de texto, aloca memória para cada linha
-void init_text_buffer(TextBuffer *txt) {
-    txt->line_count = 0;
-    for (int i = 0; i < MAX_LINES; i++) {
-        txt->lines[i] = (char*) malloc(MAX_LINE_LENGTH);
-        txt->lines[i][0] = '\0';
+// Insere a linha e registra a operação no histórico
+int do_insert(UndoRedoStack *stack, TextBuffer *txt, long index, const char *line) {
+    if (!insert_line(txt, index, line)) return 0;
+    record_op(stack, OP_INSERT, index, NULL, line, 0);
+    return 1;
+}
+
+static int edit_and_record(UndoRedoStack *stack, TextBuffer *txt, long index,
+                           const char *line, int chained) {
+    size_t len = 0;
+    const char *cur = get_line(txt, index, &len);
+    char *old = dup_text(cur, len);
+    int ok = edit_line(txt, index, line);
+    if (ok) record_op(stack, OP_EDIT, index, old, line, chained);
+    free(old);
+    return ok;
+}
+
+// Edita a linha e registra a operação (com o texto anterior) no histórico
+int do_edit(UndoRedoStack *stack, TextBuffer *txt, long index, const char *line) {
+    return edit_and_record(stack, txt, index, line, 0);
+}
+
+// Remove a linha e registra a operação (com o texto removido) no histórico
+int do_remove(UndoRedoStack *stack, TextBuffer *txt, long index) {
+    size_t len = 0;
+    const char *cur = get_line(txt, index, &len);
+    char *old = dup_text(cur, len);
+    int ok = remove_line(txt, index);
+    if (ok) record_op(stack, OP_REMOVE, index, old, NULL, 0);
+    free(old);
+    return ok;
+}
+
+// Faz undo: aplica o inverso da última operação (ou do último lote),
+// em O(tamanho da edição)
+int undo(UndoRedoStack *stack, TextBuffer *txt) {
+    if (stack->cursor == 0) {
+        printf("Nada para desfazer.\n");
+        return 0;
     }
+    EditOp *op;
+    do {
+        op = op_at(stack, stack->cursor - 1);
+        switch (op->type) {
+            case OP_INSERT: remove_line(txt, op->index); break;
+            case OP_EDIT:   edit_line(txt, op->index, op->old_text); break;
+            case OP_REMOVE: insert_line(txt, op->index, op->old_text); break;
+        }
+        stack->cursor--;
+    } while (op->chained && stack->cursor > 0);
+    return 1;
+}
+
+// Faz redo: reaplica a próxima operação (ou lote) desfeita
+int redo(UndoRedoStack *stack, TextBuffer *txt) {
+    if (stack->cursor == stack->count) {
+        printf("Nada para refazer.\n");
+        return 0;
+    }
+    do {
+        EditOp *op = op_at(stack, stack->cursor);
+        switch (op->type) {
+            case OP_INSERT: insert_line(txt, op->index, op->new_text); break;
+            case OP_EDIT:   edit_line(txt, op->index, op->new_text); break;
+            case OP_REMOVE: remove_line(txt, op->index); break;
+        }
+        stack->cursor++;
+    } while (stack->cursor < stack->count && op_at(stack, stack->cursor)->chained);
+    return 1;
 }
 
-// Copia conteúdo de um buffer para outro (para salvar estados)
-void copy_text_buffer(TextBuffer *dest, TextBuffer *src) {
-    dest->line_count = src->line_count;
-    for (int i = 0; i < src->line_count; i++) {
-        strcpy(dest->lines[i], src->lines[i]);
+// Padrão de busca: texto literal (Boyer-Moore-Horspool com pré-filtro por
+// memchr, que a libc implementa com SIMD) ou expressão regular POSIX
+typedef struct {
+    const char *pattern;
+    size_t len;
+    size_t skip[256]; // deslocamento BMH pelo último byte da janela
+    int use_regex;
+    regex_t regex;
+    char *scratch;    // cópia terminada em '\0' para o regexec
+    size_t scratch_cap;
+} Searcher;
+
+// Prepara o padrão; retorna 0 se for vazio ou uma regex inválida
+int init_searcher(Searcher *s, const char *pattern, int use_regex) {
+    s->pattern = pattern;
+    s->len = strlen(pattern);
+    s->use_regex = 0; // só depois do regcomp: free_searcher libera a regex se estiver ligado
+    s->scratch = NULL;
+    s->scratch_cap = 0;
+    if (s->len == 0) {
+        printf("Padrão de busca vazio.\n");
+        return 0;
     }
-    for (int i = src->line_count; i < MAX_LINES; i++) {
-        dest->lines[i][0] = '\0';
+    if (use_regex) {
+        int err = regcomp(&s->regex, pattern, REG_EXTENDED);
+        if (err != 0) {
+            char msg[256];
+            regerror(err, &s->regex, msg, sizeof(msg));
+            printf("Expressão regular inválida: %s\n", msg);
+            return 0;
+        }
+        s->use_regex = 1;
+        return 1;
     }
+    for (int c = 0; c < 256; c++) s->skip[c] = s->len;
+    for (size_t i = 0; i + 1 < s->len; i++) {
+        s->skip[(unsigned char) pattern[i]] = s->len - 1 - i;
+    }
+    return 1;
 }
 
-// Inicializa pilha de undo/redo
-void init_undo_redo(UndoRedoStack *stack) {
-    stack->top = -1;
-    stack->max_state = -1;
+void free_searcher(Searcher *s) {
+    if (s->use_regex) regfree(&s->regex);
+    free(s->scratch);
 }
 
-// Salva estado atual do texto para undo/redo
-void save_state(UndoRedoStack *stack, TextBuffer *txt) {
-    if (stack->top < UNDO_REDO_DEPTH - 1) {
-        stack->top++;
-        stack->max_state = stack->top;
-        copy_text_buffer(&stack->states[stack->top], txt);
-    } else {
-        // Se atingiu limite, descarta o mais antigo e desloca para esquerda
-        for (int i = 0; i < UNDO_REDO_DEPTH - 1; i++) {
-            copy_text_buffer(&stack->states[i], &stack->states[i+1]);
-        }
-        copy_text_buffer(&stack->states[UNDO_REDO_DEPTH-1], txt);
+// Busca literal em text[from, len): memchr salta até o próximo candidato
+// para o primeiro byte e a tabela BMH descarta janelas que não casam
+static const char* bmh_find(const Searcher *s, const char *text, size_t from, size_t len) {
+    size_t m = s->len;
+    const unsigned char *pat = (const unsigned char*) s->pattern;
+    size_t i = from;
+    while (i + m <= len) {
+        const char *p = memchr(text + i, pat[0], len - m - i + 1);
+        if (!p) return NULL;
+        i = (size_t) (p - text);
+        if (m == 1) return p;
+        size_t j = m - 1;
+        while (j > 0 && (unsigned char) text[i + j] == pat[j]) j--;
+        if (j == 0) return text + i;
+        i += s->skip[(unsigned char) text[i + m - 1]];
     }
+    return NULL;
 }
 
-// Faz undo: retorna ao estado anterior se possível
-int undo(UndoRedoStack *stack, TextBuffer *txt) {
-    if (stack->top > 0) {
-        stack->top--;
-        copy_text_buffer(txt, &stack->states[stack->top]);
+// Próxima ocorrência na linha text[0, len) a partir de from. terminated indica
+// se text[len] é '\0' (senão a regex trabalha sobre uma cópia).
+static int search_in_line(Searcher *s, const char *text, size_t len, int terminated,
+                          size_t from, size_t *pos, size_t *mlen) {
+    if (!s->use_regex) {
+        const char *p = bmh_find(s, text, from, len);
+        if (!p) return 0;
+        *pos = (size_t) (p - text);
+        *mlen = s->len;
         return 1;
     }
-    printf("Nada para desfazer.\n");
-    return 0;
+    if (from > len) return 0;
+    if (!terminated) {
+        if (len + 1 > s->scratch_cap) {
+            s->scratch_cap = len + 1 > 2 * s->scratch_cap ? len + 1 : 2 * s->scratch_cap;
+            s->scratch = (char*) realloc(s->scratch, s->scratch_cap);
+            if (!s->scratch) {
+                printf("Erro ao alocar memória para a busca.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        memcpy(s->scratch, text, len);
+        s->scratch[len] = '\0';
+        text = s->scratch;
+    }
+    regmatch_t m;
+    if (regexec(&s->regex, text + from, 1, &m, from > 0 ? REG_NOTBOL : 0) != 0) return 0;
+    *pos = from + (size_t) m.rm_so;
+    *mlen = (size_t) (m.rm_eo - m.rm_so);
+    return 1;
 }
 
-// Faz redo: avança ao próximo estado se possível
-int redo(UndoRedoStack *stack, TextBuffer *txt) {
-    if (stack->top < stack->max_state) {
-        stack->top++;
-        copy_text_buffer(txt, &stack->states[stack->top]);
-        return 1;
+// Chamada para cada ocorrência (linha 1-based); retorna 0 para parar a busca
+typedef int (*MatchFn)(void *ctx, size_t line_no, const char *line, size_t len,
+                       size_t pos, size_t mlen);
+
+typedef struct {
+    Searcher *s;
+    MappedFile *src;
+    size_t from; // primeira linha (0-based) a examinar
+    MatchFn fn;
+    void *ctx;
+} SearchRun;
+
+// Todas as ocorrências em uma linha
+static int search_line(SearchRun *run, size_t line_no, const char *text, size_t len,
+                       int terminated) {
+    size_t from = 0, pos, mlen;
+    while (search_in_line(run->s, text, len, terminated, from, &pos, &mlen)) {
+        if (!run->fn(run->ctx, line_no, text, len, pos, mlen)) return 0;
+        from = pos + (mlen ? mlen : 1); // casamento vazio: avança um byte
+        if (from > len) break;
     }
-    printf("Nada para refazer.\n");
-    return 0;
+    return 1;
 }
 
-// Carrega arquivo para buffer de texto, linha a linha
-int load_file(const char *filename, TextBuffer *txt) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        printf("Não foi possível abrir o arquivo %s para leitura.\n", filename);
-        return 0;
+// Maior linha k em [lo, hi) cujo início é <= off
+static size_t line_at_offset(MappedFile *mf, size_t lo, size_t hi, size_t off) {
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index_get(&mf->index, mid) <= off) lo = mid;
+        else hi = mid;
     }
-    init_text_buffer(txt);
-    char line[MAX_LINE_LENGTH];
+    return lo;
+}
 
-    while (fgets(line, sizeof(line), file) && txt->line_count < MAX_LINES) {
-        line[strcspn(line, "\r\n")] = 0; // remove \n ou \r\n
-        strcpy(txt->lines[txt->line_count], line);
-        txt->line_count++;
+// Busca nas linhas [first, first+count) do arquivo mapeado. A busca literal
+// percorre o trecho inteiro de uma vez e só então descobre a linha do
+// casamento pelo índice; o padrão não contém \n, então não cruza linhas.
+static int search_piece(SearchRun *run, size_t base, size_t first, size_t count) {
+    MappedFile *mf = run->src;
+    const char *line;
+    size_t len;
+    if (run->s->use_regex) {
+        for (size_t k = 0; k < count; k++) {
+            mapped_line(mf, first + k, &line, &len);
+            if (!search_line(run, base + k + 1, line, len, 0)) return 0;
+        }
+        return 1;
+    }
+    size_t start = index_get(&mf->index, first);
+    size_t end = index_get(&mf->index, first + count);
+    size_t from = start;
+    const char *hit;
+    while ((hit = bmh_find(run->s, mf->data, from, end)) != NULL) {
+        size_t off = (size_t) (hit - mf->data);
+        size_t k = line_at_offset(mf, first, first + count, off);
+        mapped_line(mf, k, &line, &len);
+        size_t pos = off - (size_t) (line - mf->data);
+        if (!run->fn(run->ctx, base + (k - first) + 1, line, len, pos, run->s->len)) return 0;
+        from = off + run->s->len;
     }
-    fclose(file);
     return 1;
 }
 
-// Salva o buffer de texto no arquivo
-int save_file(const char *filename, TextBuffer *txt) {
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        printf("Não foi possível abrir o arquivo %s para escrita.\n", filename);
-        return 0;
+// Percorre a subárvore em ordem; base é o índice (0-based) da sua primeira linha
+static int search_tree(SearchRun *run, LineNode *n, size_t base) {
+    if (!n) return 1;
+    if (base + n->size <= run->from) return 1; // subárvore inteira antes do início
+    if (!search_tree(run, n->left, base)) return 0;
+    size_t first = base + node_size(n->left);
+    if (first + n->count > run->from) {
+        if (n->text) {
+            if (!search_line(run, first + 1, n->text, n->len, 1)) return 0;
+        } else {
+            size_t skip = run->from > first ? run->from - first : 0;
+            if (!search_piece(run, first + skip, n->first + skip, n->count - skip)) return 0;
+        }
+    }
+    return search_tree(run, n->right, first + n->count);
+}
+
+// Busca a partir da linha from_line (1-based), chamando fn a cada ocorrência
+void search_text(TextBuffer *txt, Searcher *s, long from_line, MatchFn fn, void *ctx) {
+    ensure_tree(txt);
+    SearchRun run = {s, txt->src, from_line > 1 ? (size_t) from_line - 1 : 0, fn, ctx};
+    search_tree(&run, txt->root, 0);
+}
+
+// Estado de find/find-all: quantas ocorrências, em quantas linhas, e quantas imprimir
+typedef struct {
+    size_t hits;
+    size_t lines;
+    size_t last_line;
+    size_t print_limit;
+    int first_only; // find simples: para na primeira ocorrência
+} FindCtx;
+
+static int find_match(void *arg, size_t line_no, const char *line, size_t len,
+                      size_t pos, size_t mlen) {
+    FindCtx *c = (FindCtx*) arg;
+    (void) mlen;
+    if (line_no != c->last_line) {
+        c->lines++;
+        c->last_line = line_no;
+        if (c->lines <= c->print_limit) {
+            printf("%3zu:%zu: %.*s\n", line_no, pos + 1, (int) len, line);
+        }
     }
-    for (int i = 0; i < txt->line_count; i++) {
-        fprintf(file, "%s\n", txt->lines[i]);
+    c->hits++;
+    return !c->first_only;
+}
+
+// Exibe a primeira ocorrência a partir de from_line; retorna a linha ou 0
+size_t find_text(TextBuffer *txt, Searcher *s, long from_line) {
+    FindCtx c = {0, 0, 0, 1, 1};
+    search_text(txt, s, from_line, find_match, &c);
+    if (c.hits == 0) printf("Texto não encontrado.\n");
+    return c.last_line;
+}
+
+// Exibe as linhas com ocorrências (até SEARCH_PRINT_LIMIT) e o total
+size_t find_all(TextBuffer *txt, Searcher *s) {
+    FindCtx c = {0, 0, 0, SEARCH_PRINT_LIMIT, 0};
+    search_text(txt, s, 1, find_match, &c);
+    if (c.lines > c.print_limit) {
+        printf("... (%zu linhas não exibidas)\n", c.lines - c.print_limit);
     }
-    fclose(file);
+    printf("%zu ocorrência(s) em %zu linha(s).\n", c.hits, c.lines);
+    return c.hits;
+}
+
+// Linha reescrita por replace-all
+typedef struct {
+    size_t line_no;
+    char *text;
+} Replacement;
+
+// Monta as linhas novas durante a busca: as ocorrências de uma linha chegam
+// em ordem, então basta copiar o trecho entre elas e o substituto
+typedef struct {
+    const char *with;
+    size_t with_len;
+    size_t hits;
+    Replacement *items;
+    size_t n, cap;
+    const char *line; // linha em construção
+    size_t len, line_no, copied;
+    char *buf;
+    size_t buf_len, buf_cap;
+} ReplaceCtx;
+
+static void replace_append(ReplaceCtx *c, const char *data, size_t len) {
+    if (c->buf_len + len + 1 > c->buf_cap) {
+        c->buf_cap = (c->buf_len + len + 1) * 2;
+        c->buf = (char*) realloc(c->buf, c->buf_cap);
+        if (!c->buf) {
+            printf("Erro ao alocar memória para a substituição.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(c->buf + c->buf_len, data, len);
+    c->buf_len += len;
+    c->buf[c->buf_len] = '\0';
+}
+
+// Fecha a linha em construção: copia o restante e guarda o resultado
+static void replace_finish_line(ReplaceCtx *c) {
+    if (!c->line) return;
+    replace_append(c, c->line + c->copied, c->len - c->copied);
+    if (c->n == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 64;
+        c->items = (Replacement*) realloc(c->items, c->cap * sizeof(Replacement));
+        if (!c->items) {
+            printf("Erro ao alocar memória para a substituição.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    c->items[c->n].line_no = c->line_no;
+    c->items[c->n].text = c->buf;
+    c->n++;
+    c->buf = NULL;
+    c->buf_len = c->buf_cap = 0;
+    c->line = NULL;
+}
+
+static int replace_match(void *arg, size_t line_no, const char *line, size_t len,
+                         size_t pos, size_t mlen) {
+    ReplaceCtx *c = (ReplaceCtx*) arg;
+    if (!c->line || line_no != c->line_no) {
+        replace_finish_line(c);
+        c->line = line;
+        c->len = len;
+        c->line_no = line_no;
+        c->copied = 0;
+        c->buf_cap = len + c->with_len + 64;
+        c->buf = (char*) malloc(c->buf_cap);
+        if (!c->buf) {
+            printf("Erro ao alocar memória para a substituição.\n");
+            exit(EXIT_FAILURE);
+        }
+        c->buf[0] = '\0';
+    }
+    replace_append(c, line + c->copied, pos - c->copied);
+    replace_append(c, c->with, c->with_len);
+    c->copied = pos + mlen;
+    c->hits++;
     return 1;
 }
 
-// Exibe o conteúdo atual do buffer com numeração de linhas
-void display_text(TextBuffer *txt) {
-    printf("\n=== Texto Atualmente ===\n");
-    for (int i = 0; i < txt->line_count; i++) {
-        printf("%3d: %s\n", i+1, txt->lines[i]);
+// Substitui todas as ocorrências por with. As linhas novas são montadas em
+// uma única passada e aplicadas em lote, com uma só entrada de undo (sem
+// histórico se stack for NULL). Retorna as ocorrências e, em lines, as linhas.
+size_t replace_all(UndoRedoStack *stack, TextBuffer *txt, Searcher *s, const char *with,
+                   size_t *lines) {
+    ReplaceCtx c;
+    memset(&c, 0, sizeof(c));
+    c.with = with;
+    c.with_len = strlen(with);
+    search_text(txt, s, 1, replace_match, &c);
+    replace_finish_line(&c);
+
+    for (size_t i = 0; i < c.n; i++) {
+        if (stack) {
+            edit_and_record(stack, txt, (long) c.items[i].line_no, c.items[i].text, i > 0);
+        } else {
+            edit_line(txt, (long) c.items[i].line_no, c.items[i].text);
+        }
+        free(c.items[i].text);
     }
-    printf("=======================\n");
+    free(c.items);
+    if (lines) *lines = c.n;
+    return c.hits;
 }
 
-// Insere nova linha no índice informado (1-based), empurrando as linhas para baixo
-void insert_line(TextBuffer *txt, int index, const char *line) {
-    if (txt->line_count >= MAX_LINES) {
-        printf("Limite de linhas atingido.\n");
-        return;
+// Lê uma linha da entrada padrão sem limite de tamanho, removendo \n ou \r\n
+static int read_input_line(char **buf, size_t *cap) {
+    if (getline(buf, cap, stdin) == -1) return 0;
+    (*buf)[strcspn(*buf, "\r\n")] = 0;
+    return 1;
+}
+
+// Comandos de edição aceitos pelos scripts do modo batch e pelo modo de visualização
+typedef enum { CMD_INSERT, CMD_EDIT, CMD_REMOVE, CMD_REPLACE, CMD_SAVE } BatchCmdType;
+
+typedef struct {
+    BatchCmdType type;
+    long index;
+    char *text;     // texto (insert/edit), padrão (replace) ou destino (save)
+    char *with;     // substituto (replace)
+    int use_regex;
+    int script_line;
+} BatchCmd;
+
+// Interpreta uma linha do script. Formatos:
+//   insert N texto | edit N texto | remove N
+//   replace /padrão/substituto/[r]   (qualquer delimitador; r = regex)
+//   save [destino]                   ({} no destino vira o nome do arquivo)
+static int parse_batch_cmd(char *line, BatchCmd *cmd) {
+    char *arg = line + strcspn(line, " \t");
+    if (*arg) *arg++ = '\0';
+    cmd->text = cmd->with = NULL;
+    cmd->use_regex = 0;
+    cmd->index = 0;
+
+    if (strcmp(line, "insert") == 0 || strcmp(line, "edit") == 0) {
+        char *end;
+        cmd->type = line[0] == 'i' ? CMD_INSERT : CMD_EDIT;
+        cmd->index = strtol(arg, &end, 10);
+        if (end == arg) return 0;
+        if (*end == ' ' || *end == '\t') end++;
+        cmd->text = strdup(end);
+        return cmd->text != NULL;
     }
-    if (index < 1 || index > txt->line_count + 1) {
-        printf("Índice inválido para inserção.\n");
-        return;
+    if (strcmp(line, "remove") == 0) {
+        char *end;
+        cmd->type = CMD_REMOVE;
+        cmd->index = strtol(arg, &end, 10);
+        return end != arg;
     }
-    for (int i = txt->line_count; i >= index; i--) {
-        strcpy(txt->lines[i], txt->lines[i - 1]);
+    if (strcmp(line, "replace") == 0) {
+        char delim = arg[0];
+        char *pat, *with, *flags;
+        if (!delim) return 0;
+        pat = arg + 1;
+        with = strchr(pat, delim);
+        if (!with) return 0;
+        *with++ = '\0';
+        flags = strchr(with, delim);
+        if (!flags) return 0;
+        *flags++ = '\0';
+        cmd->type = CMD_REPLACE;
+        cmd->use_regex = strchr(flags, 'r') != NULL;
+        cmd->text = strdup(pat);
+        cmd->with = strdup(with);
+        return cmd->text && cmd->with && pat[0] != '\0';
+    }
+    if (strcmp(line, "save") == 0) {
+        cmd->type = CMD_SAVE;
+        if (*arg) {
+            cmd->text = strdup(arg);
+            return cmd->text != NULL;
+        }
+        return 1;
     }
-    strncpy(txt->lines[index - 1], line, MAX_LINE_LENGTH);
-    txt->line_count++;
+    return 0;
 }
 
-// Edita linha existente (1-based)
-void edit_line(TextBuffer *txt, int index, const char *line) {
-    if (index < 1 || index > txt->line_count) {
-        printf("Índice inválido para edição.\n");
-        return;
+// Modo de visualização: mostra só a janela visível do buffer. Cada quadro é
+// montado em memória e enviado com um único write; linhas da tela iguais às
+// do quadro anterior não são reenviadas, então o tráfego por comando é
+// proporcional ao que mudou na tela, não ao tamanho do arquivo.
+typedef struct {
+    int rows, cols;     // tamanho do terminal
+    int text_rows;      // linhas da tela usadas pelo texto
+    long top;           // primeira linha do buffer exibida
+    char **shown;       // conteúdo atual de cada linha da tela (NULL = desconhecido)
+    size_t *shown_len;
+    char *row;          // linha em montagem
+    char *out;          // quadro em montagem
+    size_t out_len, out_cap;
+} Viewport;
+
+static void view_append(Viewport *v, const char *s, size_t len) {
+    if (v->out_len + len > v->out_cap) {
+        size_t cap = v->out_cap ? v->out_cap * 2 : 4096;
+        while (cap < v->out_len + len) cap *= 2;
+        v->out = (char*) realloc(v->out, cap);
+        if (!v->out) {
+            printf("Erro ao alocar memória para a tela.\n");
+            exit(EXIT_FAILURE);
+        }
+        v->out_cap = cap;
     }
-    strncpy(txt->lines[index - 1], line, MAX_LINE_LENGTH);
+    memcpy(v->out + v->out_len, s, len);
+    v->out_len += len;
 }
 
-// Remove linha do índice informado (1-based), puxando linhas para cima
-void remove_line(TextBuffer *txt, int index) {
-    if (index < 1 || index > txt->line_count) {
-        printf("Índice inválido para remoção.\n");
-        return;
+static void init_viewport(Viewport *v) {
+    struct winsize ws;
+    memset(v, 0, sizeof(*v));
+    v->rows = VIEW_DEFAULT_ROWS;
+    v->cols = VIEW_DEFAULT_COLS;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row >= 4 && ws.ws_col >= 20) {
+        v->rows = ws.ws_row;
+        v->cols = ws.ws_col;
+    }
+    // Texto, barra de status, prompt e uma linha livre para o Enter do
+    // prompt não rolar a tela
+    v->text_rows = v->rows - 3;
+    v->top = 1;
+    v->shown = (char**) calloc((size_t) v->rows, sizeof(char*));
+    v->shown_len = (size_t*) calloc((size_t) v->rows, sizeof(size_t));
+    v->row = (char*) malloc((size_t) v->cols + 1);
+    if (!v->shown || !v->shown_len || !v->row) {
+        printf("Erro ao alocar memória para a tela.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void free_viewport(Viewport *v) {
+    for (int r = 0; r < v->rows; r++) free(v->shown[r]);
+    free(v->shown);
+    free(v->shown_len);
+    free(v->row);
+    free(v->out);
+}
+
+// Acrescenta ao quadro a linha r da tela, se for diferente da exibida
+static void view_set_row(Viewport *v, int r, const char *text, size_t len) {
+    if (v->shown[r] && v->shown_len[r] == len && memcmp(v->shown[r], text, len) == 0) return;
+    char pos[32];
+    int n = snprintf(pos, sizeof(pos), "\x1b[%d;1H", r + 1);
+    view_append(v, pos, (size_t) n);
+    view_append(v, text, len);
+    view_append(v, "\x1b[K", 3);
+    char *copy = (char*) realloc(v->shown[r], len + 1);
+    if (!copy) {
+        printf("Erro ao alocar memória para a tela.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, text, len);
+    v->shown[r] = copy;
+    v->shown_len[r] = len;
+}
+
+// Monta a linha da tela para a linha k do buffer, cortada na largura do
+// terminal (sem partir caracteres UTF-8) e sem caracteres de controle
+static size_t view_format_line(Viewport *v, long k, const char *line, size_t len) {
+    size_t cols = (size_t) v->cols;
+    int n = snprintf(v->row, cols + 1, "%6ld: ", k);
+    size_t used = (size_t) n < cols ? (size_t) n : cols;
+    size_t room = cols - used;
+    if (len > room) {
+        len = room;
+        while (len > 0 && ((unsigned char) line[len] & 0xC0) == 0x80) len--;
     }
-    for (int i = index -1; i < txt->line_count -1; i++) {
-        strcpy(txt->lines[i], txt->lines[i+1]);
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char) line[i];
+        v->row[used + i] = (c < 0x20 || c == 0x7f) ? ' ' : (char) c;
     }
-    txt->lines[txt->line_count -1][0] = '\0';
-    txt->line_count--;
+    return used + len;
+}
+
+// Desenha a janela atual; só as linhas alteradas vão para o terminal
+static void render_viewport(TextBuffer *txt, Viewport *v, const char *status) {
+    for (int r = 0; r < v->text_rows; r++) {
+        long k = v->top + r;
+        size_t len;
+        const char *line = get_line(txt, k, &len);
+        if (line) {
+            view_set_row(v, r, v->row, view_format_line(v, k, line, len));
+        } else {
+            view_set_row(v, r, "~", 1);
+        }
+    }
+
+    char bar[256];
+    int n;
+    if (txt->pending) {
+        n = snprintf(bar, sizeof(bar), "\x1b[7m linhas %ld-%ld (indexando...) %s\x1b[0m",
+                     v->top, v->top + v->text_rows - 1, status);
+    } else {
+        n = snprintf(bar, sizeof(bar), "\x1b[7m linhas %ld-%ld de %zu %s\x1b[0m",
+                     v->top, v->top + v->text_rows - 1, line_count(txt), status);
+    }
+    if (n >= (int) sizeof(bar)) n = (int) sizeof(bar) - 1;
+    view_set_row(v, v->text_rows, bar, (size_t) n);
+
+    // O prompt é sempre redesenhado: o eco da digitação o alterou
+    char pos[32];
+    n = snprintf(pos, sizeof(pos), "\x1b[%d;1H\x1b[K: ", v->text_rows + 2);
+    view_append(v, pos, (size_t) n);
+
+    fflush(stdout);
+    write_all(STDOUT_FILENO, v->out, v->out_len);
+    v->out_len = 0;
+}
+
+// Laço do modo de visualização. Comandos:
+//   Enter ou n: próxima página   p: página anterior   g N (ou N): ir para a linha N
+//   insert N texto | edit N texto | remove N   u: desfazer   r: refazer   q: sair
+void view_mode(TextBuffer *txt, UndoRedoStack *urs) {
+    Viewport v;
+    char *line = NULL;
+    size_t line_cap = 0;
+    const char *status = "";
+    init_viewport(&v);
+    fflush(stdout);
+    write_all(STDOUT_FILENO, "\x1b[H\x1b[2J", 7);
+
+    for (;;) {
+        render_viewport(txt, &v, status);
+        if (!read_input_line(&line, &line_cap)) break;
+        status = "";
+
+        char *end;
+        long target = -1;
+        if (line[0] == '\0' || strcmp(line, "n") == 0) {
+            target = v.top + v.text_rows;
+        } else if (strcmp(line, "p") == 0) {
+            target = v.top - v.text_rows;
+        } else if (strcmp(line, "q") == 0) {
+            break;
+        } else if (strcmp(line, "u") == 0) {
+            if (urs->cursor == 0) status = "| nada para desfazer";
+            else undo(urs, txt);
+        } else if (strcmp(line, "r") == 0) {
+            if (urs->cursor == urs->count) status = "| nada para refazer";
+            else redo(urs, txt);
+        } else if ((line[0] == 'g' && line[1] == ' ') || (line[0] >= '0' && line[0] <= '9')) {
+            target = strtol(line + (line[0] == 'g' ? 2 : 0), &end, 10);
+        } else {
+            BatchCmd cmd;
+            if (!parse_batch_cmd(line, &cmd) ||
+                (cmd.type != CMD_INSERT && cmd.type != CMD_EDIT && cmd.type != CMD_REMOVE)) {
+                status = "| comando inválido";
+            } else {
+                size_t total = line_count(txt);
+                size_t limit = cmd.type == CMD_INSERT ? total + 1 : total;
+                if (cmd.index < 1 || (size_t) cmd.index > limit) {
+                    status = "| índice inválido";
+                } else if (cmd.type == CMD_INSERT) {
+                    do_insert(urs, txt, cmd.index, cmd.text);
+                } else if (cmd.type == CMD_EDIT) {
+                    do_edit(urs, txt, cmd.index, cmd.text);
+                } else {
+                    do_remove(urs, txt, cmd.index);
+                }
+            }
+            free(cmd.text);
+            free(cmd.with);
+        }
+
+        if (target != -1) {
+            // Sem passar do fim: a última página começa em total - text_rows + 1
+            if (!txt->pending) {
+                long last = (long) line_count(txt) - v.text_rows + 1;
+                if (target > last) target = last;
+            }
+            v.top = target < 1 ? 1 : target;
+        }
+    }
+
+    char pos[32];
+    int n = snprintf(pos, sizeof(pos), "\x1b[%d;1H\n", v.rows);
+    write_all(STDOUT_FILENO, pos, (size_t) n);
+    free(line);
+    free_viewport(&v);
+}
+
+// Carrega filename e associa o journal de autosave; se houver edições não
+// salvas de uma sessão interrompida, oferece reaplicá-las
+int open_session(TextBuffer *txt, UndoRedoStack *urs, const char *filename) {
+    if (!load_file(filename, txt)) return 0;
+    printf("Arquivo carregado com sucesso.\n");
+    clear_undo_redo(urs); // Histórico recomeça no arquivo carregado
+    close_journal(txt->journal, 1); // edições do arquivo anterior foram descartadas
+    txt->journal = NULL;
+
+    int recover = 0;
+    if (journal_pending(filename)) {
+        char *answer = NULL;
+        size_t answer_cap = 0;
+        printf("Há edições não salvas de uma sessão anterior. Recuperar? (s/n): ");
+        if (read_input_line(&answer, &answer_cap)) {
+            recover = answer[0] == 's' || answer[0] == 'S';
+        }
+        free(answer);
+    }
+    if (recover) {
+        printf("%zu edições recuperadas.\n", replay_journal(filename, txt));
+    }
+    txt->journal = open_journal(filename, recover);
+    return 1;
 }
 
 // Menu principal de operações
 void menu(TextBuffer *txt, UndoRedoStack *urs) {
     int running = 1;
+    char *line = NULL, *pattern = NULL;
+    size_t line_cap = 0, pattern_cap = 0;
+    Searcher searcher;
     while (running) {
         printf("\n--- Editor de Texto Simples ---\n");
         printf("1. Exibir texto\n");
@@ -177,10 +2103,14 @@ void menu(TextBuffer *txt, UndoRedoStack *urs) {
         printf("7. Salvar arquivo\n");
         printf("8. Carregar arquivo\n");
         printf("9. Sair\n");
+        printf("10. Buscar\n");
+        printf("11. Buscar todas\n");
+        printf("12. Substituir todas\n");
+        printf("13. Visualizar em tela\n");
         printf("Escolha: ");
 
-        int choice, idx;
-        char line[MAX_LINE_LENGTH];
+        int choice;
+        long idx;
         char filename[256];
         scanf("%d", &choice);
         while(getchar() != '\n');
@@ -191,30 +2121,25 @@ void menu(TextBuffer *txt, UndoRedoStack *urs) {
                 break;
             case 2:
                 printf("Digite o número da linha para inserir: ");
-                scanf("%d", &idx);
+                scanf("%ld", &idx);
                 while(getchar() != '\n');
                 printf("Digite o texto a ser inserido: ");
-                fgets(line, sizeof(line), stdin);
-                line[strcspn(line, "\r\n")] = 0;
-                save_state(urs, txt);
-                insert_line(txt, idx, line);
+                if (!read_input_line(&line, &line_cap)) break;
+                do_insert(urs, txt, idx, line);
                 break;
             case 3:
                 printf("Digite o número da linha para editar: ");
-                scanf("%d", &idx);
+                scanf("%ld", &idx);
                 while(getchar() != '\n');
                 printf("Digite o novo texto: ");
-                fgets(line, sizeof(line), stdin);
-                line[strcspn(line, "\r\n")] = 0;
-                save_state(urs, txt);
-                edit_line(txt, idx, line);
+                if (!read_input_line(&line, &line_cap)) break;
+                do_edit(urs, txt, idx, line);
                 break;
             case 4:
                 printf("Digite o número da linha para remover: ");
-                scanf("%d", &idx);
+                scanf("%ld", &idx);
                 while(getchar() != '\n');
-                save_state(urs, txt);
-                remove_line(txt, idx);
+                do_remove(urs, txt, idx);
                 break;
             case 5:
                 if(undo(urs, txt)) {
@@ -232,40 +2157,466 @@ void menu(TextBuffer *txt, UndoRedoStack *urs) {
                 filename[strcspn(filename, "\r\n")] = 0;
                 if (save_file(filename, txt)) {
                     printf("Arquivo salvo com sucesso.\n");
+                    // O journal recomeça a partir da versão salva
+                    close_journal(txt->journal, 1);
+                    txt->journal = open_journal(filename, 0);
                 }
                 break;
             case 8:
                 printf("Digite o nome do arquivo para carregar: ");
                 fgets(filename, sizeof(filename), stdin);
                 filename[strcspn(filename, "\r\n")] = 0;
-                if (load_file(filename, txt)) {
-                    printf("Arquivo carregado com sucesso.\n");
-                    save_state(urs, txt); // Estado inicial para undo
-                }
+                open_session(txt, urs, filename);
                 break;
             case 9:
+                // Saída normal: edições não salvas são descartadas
+                close_journal(txt->journal, 1);
+                txt->journal = NULL;
                 running = 0;
                 break;
+            case 10:
+            case 11:
+            case 12:
+                printf("Digite o texto a buscar: ");
+                if (!read_input_line(&pattern, &pattern_cap)) break;
+                printf("Usar expressão regular? (s/n): ");
+                if (!read_input_line(&line, &line_cap)) break;
+                if (!init_searcher(&searcher, pattern, line[0] == 's' || line[0] == 'S')) {
+                    free_searcher(&searcher);
+                    break;
+                }
+                if (choice == 10) {
+                    printf("Buscar a partir da linha: ");
+                    scanf("%ld", &idx);
+                    while(getchar() != '\n');
+                    find_text(txt, &searcher, idx);
+                } else if (choice == 11) {
+                    find_all(txt, &searcher);
+                } else {
+                    printf("Substituir por: ");
+                    if (read_input_line(&line, &line_cap)) {
+                        size_t lines;
+                        size_t hits = replace_all(urs, txt, &searcher, line, &lines);
+                        printf("%zu ocorrência(s) substituída(s) em %zu linha(s).\n", hits, lines);
+                    }
+                }
+                free_searcher(&searcher);
+                break;
+            case 13:
+                view_mode(txt, urs);
+                break;
             default:
                 printf("Opção inválida.\n");
         }
     }
+    free(line);
+    free(pattern);
+}
+
+// Benchmarks e modo batch (opções de linha de comando)
+static double elapsed_ms(struct timespec a, struct timespec b) {
+    return (double) (b.tv_sec - a.tv_sec) * 1e3 + (double) (b.tv_nsec - a.tv_nsec) / 1e6;
+}
+
+// Monta o índice completo de data[0, size) com o scanner informado
+static void build_line_index(const char *data, size_t size, ScanFn scan, LineIndex *ix) {
+    PosList local = {NULL, 0, 0};
+    index_push(ix, 0);
+    for (size_t pos = 0; pos < size; pos += INDEX_CHUNK) {
+        size_t end = pos + INDEX_CHUNK < size ? pos + INDEX_CHUNK : size;
+        local.n = 0;
+        scan(data, pos, end, &local);
+        for (size_t i = 0; i < local.n; i++) {
+            index_push(ix, local.pos[i]);
+        }
+    }
+    if (size > 0 && data[size - 1] != '\n') index_push(ix, size);
+    free(local.pos);
+}
+
+// Micro-benchmark do indexador de linhas: compara a leitura com fgets (o
+// caminho antigo de load_file) com os scanners escalar/SSE2/AVX2 e mede o
+// acesso aleatório a linhas pelo índice
+static int bench_index(const char *filename) {
+    struct timespec t0, t1;
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        printf("Não foi possível abrir o arquivo %s para leitura.\n", filename);
+        return 0;
+    }
+    char buf[256];
+    size_t fgets_lines = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (fgets(buf, sizeof(buf), file)) {
+        size_t cut = strcspn(buf, "\r\n");
+        if (buf[cut] != '\0' || feof(file)) fgets_lines++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    int fd = fileno(file);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        printf("Arquivo vazio ou inválido para o benchmark.\n");
+        fclose(file);
+        return 0;
+    }
+    size_t size = (size_t) st.st_size;
+    double mb = (double) size / (1024.0 * 1024.0);
+    const char *data = (const char*) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    fclose(file);
+    if (data == MAP_FAILED) {
+        printf("Não foi possível mapear o arquivo %s.\n", filename);
+        return 0;
+    }
+
+    double ms = elapsed_ms(t0, t1);
+    printf("%-8s %12zu linhas %10.1f ms %10.1f MB/s\n", "fgets", fgets_lines, ms, mb / (ms / 1e3));
+
+    struct { const char *name; ScanFn fn; } scanners[3];
+    int n_scanners = 0;
+    scanners[n_scanners].name = "escalar";
+    scanners[n_scanners++].fn = scan_newlines_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        scanners[n_scanners].name = "sse2";
+        scanners[n_scanners++].fn = scan_newlines_sse2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        scanners[n_scanners].name = "avx2";
+        scanners[n_scanners++].fn = scan_newlines_avx2;
+    }
+#endif
+
+    LineIndex ix = {0};
+    for (int s = 0; s < n_scanners; s++) {
+        free_line_index(&ix);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        build_line_index(data, size, scanners[s].fn, &ix);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        ms = elapsed_ms(t0, t1);
+        printf("%-8s %12zu linhas %10.1f ms %10.1f MB/s\n",
+               scanners[s].name, ix.count - 1, ms, mb / (ms / 1e3));
+    }
+
+    // Acesso aleatório: início e fim de linhas sorteadas, como em mapped_line
+    size_t lines = ix.count - 1, lookups = 1000000, checksum = 0;
+    unsigned int seed = 12345;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t i = 0; i < lookups && lines > 0; i++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t k = seed % lines;
+        checksum += index_get(&ix, k + 1) - index_get(&ix, k);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("acesso aleatório: %.1f ns/linha (checksum %zu)\n",
+           elapsed_ms(t0, t1) * 1e6 / (double) lookups, checksum);
+    printf("índice: %.1f bytes/linha\n",
+           lines ? (double) (ix.cap * sizeof(uint32_t)) / (double) lines : 0.0);
+
+    free_line_index(&ix);
+    munmap((void*) data, size);
+    return 1;
+}
+
+// Modo batch: script compartilhado, fila de arquivos e totais das threads
+typedef struct {
+    BatchCmd *cmds;
+    size_t n;
+    char **files;
+    int n_files;
+    int next_file;  // próximo arquivo a processar (compartilhado entre as threads)
+    size_t edits;   // totais acumulados pelas threads
+    int failed;
+    pthread_mutex_t lock;
+} BatchJob;
+
+static void free_batch_cmds(BatchCmd *cmds, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        free(cmds[i].text);
+        free(cmds[i].with);
+    }
+    free(cmds);
+}
+
+// Lê o script inteiro; linhas vazias e começadas por # são ignoradas
+static int load_batch_script(const char *filename, BatchCmd **out, size_t *n) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        printf("Não foi possível abrir o script %s.\n", filename);
+        return 0;
+    }
+    BatchCmd *cmds = NULL;
+    size_t cap = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    int line_no = 0, ok = 1;
+    *n = 0;
+    while (getline(&line, &line_cap, file) != -1) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = 0;
+        if (line[0] == '\0' || line[0] == '#') continue;
+        if (*n == cap) {
+            cap = cap ? cap * 2 : 16;
+            cmds = (BatchCmd*) realloc(cmds, cap * sizeof(BatchCmd));
+            if (!cmds) {
+                printf("Erro ao alocar memória para o script.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (!parse_batch_cmd(line, &cmds[*n])) {
+            printf("%s:%d: comando inválido.\n", filename, line_no);
+            free(cmds[*n].text);
+            free(cmds[*n].with);
+            ok = 0;
+            break;
+        }
+        cmds[*n].script_line = line_no;
+        (*n)++;
+    }
+    free(line);
+    fclose(file);
+    if (!ok) {
+        free_batch_cmds(cmds, *n);
+        return 0;
+    }
+    *out = cmds;
+    return 1;
+}
+
+// Monta o destino de save trocando {} pelo nome do arquivo processado
+static char* batch_save_target(const char *pattern, const char *filename) {
+    if (!pattern) return strdup(filename);
+    const char *mark = strstr(pattern, "{}");
+    if (!mark) return strdup(pattern);
+    size_t head = (size_t) (mark - pattern);
+    size_t size = strlen(pattern) - 2 + strlen(filename) + 1;
+    char *target = (char*) malloc(size);
+    if (target) snprintf(target, size, "%.*s%s%s", (int) head, pattern, filename, mark + 2);
+    return target;
+}
+
+// Aplica o script a um arquivo; retorna o número de edições ou -1 em erro.
+// Os índices são validados aqui, para que nada seja impresso pelas threads
+// além das falhas.
+static long run_batch_file(BatchJob *job, TextBuffer *txt, const char *filename) {
+    long edits = 0;
+    if (!load_file(filename, txt)) return -1;
+    for (size_t i = 0; i < job->n; i++) {
+        BatchCmd *cmd = &job->cmds[i];
+        size_t total = line_count(txt);
+        long done = 1;
+        int ok = 1;
+        switch (cmd->type) {
+            case CMD_INSERT:
+                ok = cmd->index >= 1 && (size_t) cmd->index <= total + 1 &&
+                     insert_line(txt, cmd->index, cmd->text);
+                break;
+            case CMD_EDIT:
+                ok = cmd->index >= 1 && (size_t) cmd->index <= total &&
+                     edit_line(txt, cmd->index, cmd->text);
+                break;
+            case CMD_REMOVE:
+                ok = cmd->index >= 1 && (size_t) cmd->index <= total &&
+                     remove_line(txt, cmd->index);
+                break;
+            case CMD_REPLACE: {
+                Searcher s;
+                ok = init_searcher(&s, cmd->text, cmd->use_regex);
+                if (ok) done = (long) replace_all(NULL, txt, &s, cmd->with, NULL);
+                free_searcher(&s);
+                break;
+            }
+            case CMD_SAVE: {
+                char *target = batch_save_target(cmd->text, filename);
+                ok = target && save_file(target, txt);
+                free(target);
+                done = 0;
+                break;
+            }
+        }
+        if (!ok) {
+            printf("%s: falha no comando da linha %d do script.\n", filename, cmd->script_line);
+            return -1;
+        }
+        edits += done;
+    }
+    return edits;
+}
+
+// Thread do pool: pega o próximo arquivo da fila compartilhada até acabar
+static void* batch_worker(void *arg) {
+    BatchJob *job = (BatchJob*) arg;
+    TextBuffer txt;
+    init_text_buffer(&txt);
+    size_t edits = 0;
+    int failed = 0;
+    for (;;) {
+        int i = __atomic_fetch_add(&job->next_file, 1, __ATOMIC_RELAXED);
+        if (i >= job->n_files) break;
+        long n = run_batch_file(job, &txt, job->files[i]);
+        if (n < 0) failed++;
+        else edits += (size_t) n;
+    }
+    free_text_buffer(&txt);
+    pthread_mutex_lock(&job->lock);
+    job->edits += edits;
+    job->failed += failed;
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+// Modo batch: aplica o script a todos os arquivos, em paralelo com jobs
+// threads, sem menu nem prompts, e informa a vazão ao final
+static int run_batch(const char *script, char **files, int n_files, int jobs) {
+    BatchJob job;
+    if (!load_batch_script(script, &job.cmds, &job.n)) return 0;
+    job.files = files;
+    job.n_files = n_files;
+    job.next_file = 0;
+    job.edits = 0;
+    job.failed = 0;
+    pthread_mutex_init(&job.lock, NULL);
+
+    if (jobs < 1) jobs = 1;
+    if (jobs > n_files) jobs = n_files > 0 ? n_files : 1;
+    pthread_t *threads = (pthread_t*) malloc((size_t) jobs * sizeof(pthread_t));
+    if (!threads) {
+        printf("Erro ao alocar memória para as threads.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < jobs; i++) {
+        if (pthread_create(&threads[i], NULL, batch_worker, &job) != 0) {
+            printf("Erro ao criar thread do modo batch.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < jobs; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = elapsed_ms(t0, t1) / 1e3;
+
+    printf("%d arquivo(s), %d com falha, %zu edição(ões) em %.3f s com %d thread(s)\n",
+           n_files, job.failed, job.edits, secs, jobs);
+    printf("%.1f arquivos/s, %.1f edições/s\n",
+           secs > 0 ? n_files / secs : 0.0, secs > 0 ? (double) job.edits / secs : 0.0);
+
+    free(threads);
+    free_batch_cmds(job.cmds, job.n);
+    pthread_mutex_destroy(&job.lock);
+    return job.failed == 0;
+}
+
+// Caminho antigo de save_file, mantido só para comparação no benchmark
+static void fprintf_tree(FILE *file, LineNode *n) {
+    if (!n) return;
+    fprintf_tree(file, n->left);
+    fprintf(file, "%s\n", n->text);
+    fprintf_tree(file, n->right);
+}
+
+// Benchmark de gravação: compara fprintf por linha (caminho antigo, sem
+// fsync) com o salvamento atômico via writev, para linhas próprias e para
+// um arquivo mapeado (trechos gravados direto do mapeamento)
+static int bench_save(size_t lines, size_t width) {
+    struct timespec t0, t1;
+    const char *path = "bench_save.tmp";
+    TextBuffer txt;
+    init_text_buffer(&txt);
+    char *line = (char*) malloc(width + 1);
+    if (!line) return 0;
+    for (size_t i = 0; i < lines; i++) {
+        for (size_t j = 0; j < width; j++) line[j] = (char) ('a' + (i + j) % 26);
+        append_line(&txt, line, width);
+    }
+    free(line);
+    double mb = (double) (lines * (width + 1)) / (1024.0 * 1024.0);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        free_text_buffer(&txt);
+        return 0;
+    }
+    fprintf_tree(file, txt.root);
+    fclose(file);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = elapsed_ms(t0, t1);
+    printf("%-28s %10.1f ms %10.1f MB/s\n", "fprintf (sem fsync)", ms, mb / (ms / 1e3));
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int ok = save_file(path, &txt);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ms = elapsed_ms(t0, t1);
+    printf("%-28s %10.1f ms %10.1f MB/s\n", "writev+fsync (linhas)", ms, mb / (ms / 1e3));
+
+    // Recarrega por mmap e edita uma linha no meio: o resto sai em trechos
+    if (ok && load_file(path, &txt)) {
+        edit_line(&txt, (long) (lines / 2) + 1, "linha editada");
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        ok = save_file(path, &txt);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        ms = elapsed_ms(t0, t1);
+        printf("%-28s %10.1f ms %10.1f MB/s\n", "writev+fsync (mapeado)", ms, mb / (ms / 1e3));
+    }
+    free_text_buffer(&txt);
+    unlink(path);
+    return ok;
 }
 
 // FUNÇÃO PRINCIPAL
-int main() {
+int main(int argc, char *argv[]) {
     TextBuffer txt;
     UndoRedoStack urs;
+    size_t undo_budget = UNDO_MEMORY_BUDGET;
+    const char *batch_script = NULL;
+    int jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    char **files = (char**) calloc((size_t) argc, sizeof(char*));
+    int n_files = 0;
+
+    // --undo-budget <bytes> ajusta a memória máxima do histórico;
+    // --batch <script> [-j N] arquivo... aplica o script sem menu;
+    // um arquivo sem --batch é aberto no menu (com recuperação do journal);
+    // --bench-index <arquivo> e --bench-save <linhas> [largura] rodam os
+    // benchmarks do indexador e da gravação e saem
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_script = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--undo-budget") == 0 && i + 1 < argc) {
+            undo_budget = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bench-index") == 0 && i + 1 < argc) {
+            return bench_index(argv[i + 1]) ? 0 : 1;
+        } else if (strcmp(argv[i], "--bench-save") == 0 && i + 1 < argc) {
+            size_t width = (i + 2 < argc) ? strtoull(argv[i + 2], NULL, 10) : 80;
+            return bench_save(strtoull(argv[i + 1], NULL, 10), width) ? 0 : 1;
+        } else if (files) {
+            files[n_files++] = argv[i];
+        }
+    }
+    if (batch_script) {
+        int ok = run_batch(batch_script, files, n_files, jobs);
+        free(files);
+        return ok ? 0 : 1;
+    }
+
     init_text_buffer(&txt);
-    init_undo_redo(&urs);
-    save_state(&urs, &txt); // Estado inicial vazio
+    init_undo_redo(&urs, undo_budget);
+    if (n_files > 0) {
+        open_session(&txt, &urs, files[0]);
+    }
+    free(files);
 
     menu(&txt, &urs);
 
     // Liberação de memória
-    for (int i=0; i<MAX_LINES; i++) {
-        free(txt.lines[i]);
-    }
+    free_text_buffer(&txt);
+    free_undo_redo(&urs);
 
     return 0;
 }
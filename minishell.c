@@ -1,14 +1,34 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <spawn.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <limits.h>
 
 // Limites do shell
 #define MAX_LINE 1024
 #define MAX_ARGS 64
 #define DELIM " \t\r\n"
+#define SPLICE_CHUNK (1 << 20) // Máximo pedido por chamada de splice/copy_file_range
+#define COPY_BUF 65536         // Buffer da cópia comum, quando não há atalho
+#define MAX_JOBS 64            // Jobs simultâneos (primeiro e segundo plano)
+#define HASH_BUCKETS 128       // Listas da tabela de caminhos de comandos
+#define DEFAULT_PATH "/bin:/usr/bin" // PATH usado se a variável não existe (como no execvp)
+
+extern char **environ;
+
+static volatile sig_atomic_t interrupted = 0; // ^C recebido (handler de SIGINT)
+static volatile sig_atomic_t forward_pgid = 0; // grupo em primeiro plano sem o terminal
 
 // Função para ler uma linha da entrada padrão
 char* read_line() {
@@ -18,6 +38,14 @@ char* read_line() {
         exit(EXIT_FAILURE);
     }
     if (fgets(line, MAX_LINE, stdin) == NULL) {
+        // ^C no prompt (SIGINT sem SA_RESTART): descarta a linha e segue
+        if (ferror(stdin) && errno == EINTR) {
+            clearerr(stdin);
+            interrupted = 0;
+            printf("\n");
+            line[0] = '\0';
+            return line;
+        }
         free(line);
         return NULL;
     }
@@ -36,220 +64,1250 @@ int parse_line(char *line, char **args) {
     return pos;
 }
 
+// Tabela de caminhos de comandos (como o hash do bash): nome -> caminho
+// absoluto achado no PATH, para não percorrer os diretórios a cada execução.
+// Vale para o PATH com que foi preenchida; um ENOENT no caminho guardado
+// (binário removido ou movido) descarta a entrada.
+typedef struct HashEntry {
+    char *name;
+    char *path;
+    int hits;
+    struct HashEntry *next;
+} HashEntry;
+
+static HashEntry *command_hash[HASH_BUCKETS];
+static char *hashed_path = NULL; // PATH da tabela atual
+
+// FNV-1a
+unsigned hash_name(const char *name) {
+    unsigned h = 2166136261u;
+    for (; *name; name++) h = (h ^ (unsigned char) *name) * 16777619u;
+    return h % HASH_BUCKETS;
+}
+
+void hash_clear(void) {
+    for (int b = 0; b < HASH_BUCKETS; b++) {
+        HashEntry *e = command_hash[b];
+        while (e) {
+            HashEntry *next = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            e = next;
+        }
+        command_hash[b] = NULL;
+    }
+}
+
+HashEntry* hash_find(const char *name) {
+    for (HashEntry *e = command_hash[hash_name(name)]; e; e = e->next) {
+        if (strcmp(e->name, name) == 0) return e;
+    }
+    return NULL;
+}
+
+HashEntry* hash_add(const char *name, const char *path) {
+    HashEntry *e = malloc(sizeof(HashEntry));
+    if (!e || !(e->name = strdup(name)) || !(e->path = strdup(path))) {
+        fprintf(stderr, "Erro de alocação\n");
+        exit(EXIT_FAILURE);
+    }
+    unsigned b = hash_name(name);
+    e->hits = 0;
+    e->next = command_hash[b];
+    command_hash[b] = e;
+    return e;
+}
+
+int hash_forget(const char *name) {
+    for (HashEntry **link = &command_hash[hash_name(name)]; *link; link = &(*link)->next) {
+        HashEntry *e = *link;
+        if (strcmp(e->name, name) == 0) {
+            *link = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// PATH atual; se mudou desde que a tabela foi preenchida, ela é esvaziada
+const char* current_path(void) {
+    const char *path_env = getenv("PATH");
+    if (!path_env) path_env = DEFAULT_PATH;
+    if (!hashed_path || strcmp(hashed_path, path_env) != 0) {
+        hash_clear();
+        free(hashed_path);
+        hashed_path = strdup(path_env);
+        if (!hashed_path) {
+            fprintf(stderr, "Erro de alocação\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return path_env;
+}
+
+// Percorre o PATH como o execvp (entrada vazia = diretório atual) atrás de
+// um arquivo regular executável. Retorna 1 e o caminho em buf se achou.
+int search_path(const char *name, const char *path_env, char *buf, size_t size) {
+    const char *dir = path_env;
+    while (1) {
+        const char *end = strchr(dir, ':');
+        size_t len = end ? (size_t) (end - dir) : strlen(dir);
+        int written = len == 0 ? snprintf(buf, size, "%s", name)
+                               : snprintf(buf, size, "%.*s/%s", (int) len, dir, name);
+        struct stat st;
+        if (written > 0 && (size_t) written < size && stat(buf, &st) == 0 && S_ISREG(st.st_mode) &&
+            access(buf, X_OK) == 0) {
+            return 1;
+        }
+        if (!end) return 0;
+        dir = end + 1;
+    }
+}
+
+// Caminho para executar name: com '/', o próprio nome; senão, o da tabela ou
+// o achado no PATH (guardado se for absoluto: diretórios relativos dependem
+// do diretório atual). NULL se não existe. buf recebe caminhos não guardados.
+const char* resolve_command(const char *name, char *buf, size_t size) {
+    if (strchr(name, '/')) return name;
+    const char *path_env = current_path();
+    HashEntry *e = hash_find(name);
+    if (!e) {
+        if (!search_path(name, path_env, buf, size)) return NULL;
+        if (buf[0] != '/') return buf;
+        e = hash_add(name, buf);
+    }
+    e->hits++;
+    return e->path;
+}
+
+// hash            lista a tabela
+// hash -r         esvazia a tabela
+// hash -d nome... esquece os nomes
+// hash nome...    procura e guarda os nomes
+int builtin_hash(char **args) {
+    current_path(); // descarta a tabela se o PATH mudou
+    if (args[1] == NULL) {
+        int empty = 1;
+        for (int b = 0; b < HASH_BUCKETS; b++) {
+            for (HashEntry *e = command_hash[b]; e; e = e->next) {
+                if (empty) printf("acertos\tcomando\n");
+                empty = 0;
+                printf("%7d\t%s\n", e->hits, e->path);
+            }
+        }
+        if (empty) printf("hash: tabela vazia\n");
+        return 0;
+    }
+    if (strcmp(args[1], "-r") == 0) {
+        hash_clear();
+        return 0;
+    }
+    int forget = strcmp(args[1], "-d") == 0, status = 0;
+    for (int i = 1 + forget; args[i]; i++) {
+        int found;
+        if (forget) {
+            found = hash_forget(args[i]);
+        } else {
+            char buf[PATH_MAX];
+            found = hash_find(args[i]) != NULL;
+            if (!found && !strchr(args[i], '/') && search_path(args[i], hashed_path, buf, sizeof(buf)) &&
+                buf[0] == '/') {
+                hash_add(args[i], buf);
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "hash: %s: não encontrado\n", args[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// export NOME=valor...; sem argumentos, mostra o ambiente
+int builtin_export(char **args) {
+    if (args[1] == NULL) {
+        for (char **env = environ; *env; env++) printf("%s\n", *env);
+        return 0;
+    }
+    int status = 0;
+    for (int i = 1; args[i]; i++) {
+        char *eq = strchr(args[i], '=');
+        if (!eq || eq == args[i]) {
+            fprintf(stderr, "export: esperado NOME=valor: %s\n", args[i]);
+            status = 1;
+            continue;
+        }
+        *eq = '\0';
+        if (setenv(args[i], eq + 1, 1) != 0) {
+            perror("export");
+            status = 1;
+        }
+        *eq = '=';
+    }
+    return status;
+}
+
+// Comandos internos de controle de jobs
+int is_job_builtin(char **args) {
+    return strcmp(args[0], "jobs") == 0 || strcmp(args[0], "fg") == 0 || strcmp(args[0], "bg") == 0;
+}
+
 // Verifica se é comando interno
 int is_builtin(char **args) {
     if (strcmp(args[0], "cd") == 0) return 1;
     if (strcmp(args[0], "exit") == 0) return 1;
+    if (strcmp(args[0], "hash") == 0) return 1;
+    if (strcmp(args[0], "export") == 0) return 1;
+    if (is_job_builtin(args)) return 1;
     return 0;
 }
 
-// Função para executar comandos internos
+// Função para executar comandos internos; retorna o status de saída
 int exec_builtin(char **args) {
     if (strcmp(args[0], "cd") == 0) {
         if (args[1] == NULL) {
             fprintf(stderr, "cd: falha, argumento esperado\n");
-        } else {
-            if (chdir(args[1]) != 0) {
-                perror("cd");
-            }
+            return 1;
         }
-        return 1;
+        if (chdir(args[1]) != 0) {
+            perror("cd");
+            return 1;
+        }
+        return 0;
     }
     if (strcmp(args[0], "exit") == 0) {
         exit(0);
     }
+    if (strcmp(args[0], "hash") == 0) return builtin_hash(args);
+    if (strcmp(args[0], "export") == 0) return builtin_export(args);
     return 0;
 }
 
-// Executa comando simples (sem pipes ou redirecionamento)
-void exec_command(char **args) {
-    if (args[0] == NULL) return;
+// Builtins que são estágios de pipeline: rodam em uma thread do shell, com
+// suas próprias pontas de entrada e saída
+int is_stage_builtin(char **args) {
+    return strcmp(args[0], "cat") == 0 || strcmp(args[0], "tee") == 0;
+}
+
+// Movimentação de bytes pelo próprio shell. Arquivo -> arquivo usa
+// copy_file_range e, havendo um pipe em uma das pontas, splice/tee: os dados
+// não passam pelo espaço de usuário. read/write fica para o que não aceita
+// splice (terminal, arquivo em O_APPEND etc.).
+#define COPY_FALLBACK 1 // nada foi copiado e o método não serve para estes fds
 
-    if (is_builtin(args)) {
-        exec_builtin(args);
-        return;
+// ^C com um cat/tee em primeiro plano: o SIGINT chega à thread dele sem
+// SA_RESTART e as cópias desistem em vez de repetir a chamada interrompida.
+// Se o shell ficou com o terminal, o ^C é repassado aos processos do job.
+void on_sigint(int sig) {
+    int saved = errno;
+    interrupted = 1;
+    if (forward_pgid) kill(-forward_pgid, sig);
+    errno = saved;
+}
+
+// EINTR que deve ser repetido (qualquer sinal que não seja o ^C)
+int retry_eintr(void) {
+    return errno == EINTR && !interrupted;
+}
+
+int is_pipe(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+int is_regular(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0) {
+            if (retry_eintr()) continue;
+            return -1;
+        }
+        buf += w;
+        len -= w;
     }
+    return 0;
+}
 
-    pid_t pid = fork();
-    if (pid == 0) {
-        // Filho: executa o comando
-        execvp(args[0], args);
-        perror("execvp");
-        exit(EXIT_FAILURE);
-    } else if (pid < 0) {
-        perror("fork");
-    } else {
-        // Pai: espera filho terminar
-        waitpid(pid, NULL, 0);
+int rw_copy(int in, int out) {
+    char buf[COPY_BUF];
+    while (1) {
+        if (interrupted) {
+            errno = EINTR;
+            return -1;
+        }
+        ssize_t r = read(in, buf, sizeof(buf));
+        if (r == 0) return 0;
+        if (r < 0) {
+            if (retry_eintr()) continue;
+            return -1;
+        }
+        if (write_all(out, buf, r) < 0) return -1;
     }
 }
 
-// Função para encontrar operador de pipe na linha (retorna índice ou -1)
-int find_pipe(char **args) {
-    for (int i = 0; args[i]; i++) {
-        if (strcmp(args[i], "|") == 0)
-            return i;
+int copy_range_all(int in, int out) {
+    int moved = 0;
+    while (1) {
+        ssize_t r = copy_file_range(in, NULL, out, NULL, SPLICE_CHUNK, 0);
+        if (r > 0) {
+            moved = 1;
+            continue;
+        }
+        if (r == 0) return 0;
+        if (retry_eintr()) continue;
+        if (!moved && (errno == EXDEV || errno == EINVAL || errno == ENOSYS ||
+                       errno == EOPNOTSUPP || errno == EBADF)) {
+            return COPY_FALLBACK;
+        }
+        return -1;
     }
-    return -1;
 }
 
-// Trata execução de pipeline simples (dois comandos separados por '|')
-void exec_pipe(char **args) {
-    int pipe_index = find_pipe(args);
-    if (pipe_index == -1) {
-        exec_command(args);  // Sem pipe, executa normalmente
-        return;
+// splice direto; exige um pipe em uma das pontas
+int splice_all(int in, int out) {
+    int moved = 0;
+    while (1) {
+        ssize_t r = splice(in, NULL, out, NULL, SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (r > 0) {
+            moved = 1;
+            continue;
+        }
+        if (r == 0) return 0;
+        if (retry_eintr()) continue;
+        return !moved && errno == EINVAL ? COPY_FALLBACK : -1;
     }
+}
 
-    args[pipe_index] = NULL;  // Separa comando 1 e 2
+// Move exatamente len bytes que já estão no pipe from para out
+int drain_pipe(int from, int out, size_t len) {
+    while (len > 0) {
+        ssize_t r = splice(from, NULL, out, NULL, len, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (r > 0) {
+            len -= r;
+            continue;
+        }
+        if (r < 0 && retry_eintr()) continue;
+        if (r < 0 && errno == EINVAL) break; // destino sem splice
+        return -1;
+    }
+    char buf[COPY_BUF];
+    while (len > 0) {
+        ssize_t r = read(from, buf, len < sizeof(buf) ? len : sizeof(buf));
+        if (r < 0 && retry_eintr()) continue;
+        if (r <= 0 || write_all(out, buf, r) < 0) return -1;
+        len -= r;
+    }
+    return 0;
+}
 
-    char **left_cmd = args;
-    char **right_cmd = &args[pipe_index + 1];
+// Nenhuma ponta é pipe: splice em dois passos por um pipe intermediário
+int splice_via_pipe(int in, int out) {
+    int mid[2];
+    if (pipe2(mid, O_CLOEXEC) == -1) return COPY_FALLBACK;
+    int result = 0, moved = 0;
+    while (1) {
+        ssize_t r = splice(in, NULL, mid[1], NULL, SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (r < 0 && retry_eintr()) continue;
+        if (r < 0) {
+            result = !moved && errno == EINVAL ? COPY_FALLBACK : -1;
+            break;
+        }
+        if (r == 0) break;
+        moved = 1;
+        if (drain_pipe(mid[0], out, r) < 0) {
+            result = -1;
+            break;
+        }
+    }
+    close(mid[0]);
+    close(mid[1]);
+    return result;
+}
 
-    int fd[2];
-    if (pipe(fd) == -1) {
-        perror("pipe");
-        return;
+// Copia in até EOF para out pelo caminho mais barato. Retorna 0 ou -1 (errno)
+int copy_fd(int in, int out) {
+    int result = COPY_FALLBACK;
+    if (is_regular(in) && is_regular(out)) result = copy_range_all(in, out);
+    if (result == COPY_FALLBACK) {
+        result = is_pipe(in) || is_pipe(out) ? splice_all(in, out) : splice_via_pipe(in, out);
     }
+    return result == COPY_FALLBACK ? rw_copy(in, out) : result;
+}
 
-    pid_t pid1 = fork();
-    if (pid1 == 0) {  // Filho 1 executa comando da esquerda
-        close(fd[0]);  // Fecha lado de leitura do pipe
-        dup2(fd[1], STDOUT_FILENO); // Redireciona saída padrão para pipe
-        close(fd[1]);
-        exec_command(left_cmd);
-        exit(EXIT_FAILURE);
+int rw_tee(int in, const int *outs, int count) {
+    char buf[COPY_BUF];
+    while (1) {
+        if (interrupted) {
+            errno = EINTR;
+            return -1;
+        }
+        ssize_t r = read(in, buf, sizeof(buf));
+        if (r == 0) return 0;
+        if (r < 0) {
+            if (retry_eintr()) continue;
+            return -1;
+        }
+        for (int j = 0; j < count; j++) {
+            if (write_all(outs[j], buf, r) < 0) return -1;
+        }
+    }
+}
+
+// Copia in para todos os outs. tee(2) duplica o conteúdo de um pipe sem
+// consumi-lo: cada destino menos o último recebe uma cópia por um pipe de
+// rascunho, e o último consome a origem com splice. Se in não é pipe, os
+// dados entram antes em um pipe próprio (também com splice).
+int tee_fds(int in, const int *outs, int count) {
+    if (count == 1) return copy_fd(in, outs[0]);
+    int scratch[2], src[2] = { -1, -1 };
+    if (pipe2(scratch, O_CLOEXEC) == -1) return rw_tee(in, outs, count);
+    int source = in;
+    if (!is_pipe(in)) {
+        if (pipe2(src, O_CLOEXEC) == -1) {
+            close(scratch[0]);
+            close(scratch[1]);
+            return rw_tee(in, outs, count);
+        }
+        source = src[0];
+    }
+    // O rascunho precisa de tantos slots quanto a origem para o tee ser inteiro
+    int size = fcntl(source, F_GETPIPE_SZ);
+    if (size > 0) fcntl(scratch[1], F_SETPIPE_SZ, size);
+
+    int result = 0, moved = 0;
+    while (1) {
+        ssize_t n;
+        if (source != in) {
+            n = splice(in, NULL, src[1], NULL, SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (n < 0 && retry_eintr()) continue;
+            if (n < 0 && !moved && errno == EINVAL) {
+                result = rw_tee(in, outs, count); // origem sem splice (ex.: terminal)
+                break;
+            }
+            if (n <= 0) {
+                result = n < 0 ? -1 : 0;
+                break;
+            }
+        }
+        n = tee(source, scratch[1], SPLICE_CHUNK, 0);
+        if (n < 0 && retry_eintr()) continue;
+        if (n <= 0) {
+            result = n < 0 ? -1 : 0;
+            break;
+        }
+        moved = 1;
+        int ok = drain_pipe(scratch[0], outs[0], n) == 0;
+        for (int j = 1; ok && j < count - 1; j++) {
+            ok = tee(source, scratch[1], n, 0) == n && drain_pipe(scratch[0], outs[j], n) == 0;
+        }
+        if (!ok || drain_pipe(source, outs[count - 1], n) < 0) {
+            result = -1;
+            break;
+        }
+    }
+    close(scratch[0]);
+    close(scratch[1]);
+    if (src[0] != -1) {
+        close(src[0]);
+        close(src[1]);
+    }
+    return result;
+}
+
+// cat [arquivo|-]...
+int builtin_cat(char **argv, int in, int out, int err) {
+    char *stdin_only[] = { argv[0], "-", NULL };
+    if (argv[1] == NULL) argv = stdin_only;
+    int status = 0;
+    for (int i = 1; argv[i]; i++) {
+        int fd = strcmp(argv[i], "-") == 0 ? in : open(argv[i], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            dprintf(err, "cat: %s: %s\n", argv[i], strerror(errno));
+            status = 1;
+            continue;
+        }
+        int result = copy_fd(fd, out);
+        int saved = errno;
+        if (fd != in) close(fd);
+        if (result < 0) {
+            if (saved == EINTR) return 128 + SIGINT; // ^C
+            if (saved != EPIPE) dprintf(err, "cat: %s: %s\n", argv[i], strerror(saved));
+            return 1; // leitor do pipe saiu: para como o cat morto por SIGPIPE
+        }
+    }
+    return status;
+}
+
+// tee [-a] [arquivo]...
+int builtin_tee(char **argv, int in, int out, int err) {
+    int append = argv[1] && strcmp(argv[1], "-a") == 0;
+    int outs[MAX_ARGS], count = 0, status = 0;
+    outs[count++] = out;
+    for (int i = 1 + append; argv[i]; i++) {
+        int fd = open(argv[i], O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+        if (fd < 0) {
+            dprintf(err, "tee: %s: %s\n", argv[i], strerror(errno));
+            status = 1;
+        } else {
+            outs[count++] = fd;
+        }
+    }
+    if (tee_fds(in, outs, count) < 0) {
+        if (errno == EINTR) {
+            status = 128 + SIGINT; // ^C
+        } else {
+            if (errno != EPIPE) dprintf(err, "tee: %s\n", strerror(errno));
+            status = 1;
+        }
+    }
+    for (int j = 1; j < count; j++) close(outs[j]);
+    return status;
+}
+
+// Self-pipe: o handler de SIGCHLD e as threads de builtins escrevem um byte
+// quando algo termina; o laço principal só recolhe jobs se houver bytes
+static int notify_pipe[2] = { -1, -1 };
+
+void notify_main_loop(void) {
+    int saved = errno;
+    if (write(notify_pipe[1], "", 1) < 0) {
+        // Pipe cheio: já há aviso pendente
     }
+    errno = saved;
+}
 
-    pid_t pid2 = fork();
-    if (pid2 == 0) {  // Filho 2 executa comando da direita
-        close(fd[1]);  // Fecha lado de escrita do pipe
-        dup2(fd[0], STDIN_FILENO);  // Redireciona entrada padrão para pipe
-        close(fd[0]);
-        exec_command(right_cmd);
+void on_sigchld(int sig) {
+    (void) sig;
+    notify_main_loop();
+}
+
+// Estágio builtin em execução: fds -1 são os do próprio shell. argv é uma
+// cópia própria, pois a linha é liberada antes de um job em segundo plano acabar
+typedef struct {
+    char **argv;
+    int in_fd, out_fd, err_fd;
+} BuiltinStage;
+
+char** dup_argv(char **argv) {
+    int argc = 0;
+    while (argv[argc]) argc++;
+    char **copy = malloc((argc + 1) * sizeof(char*));
+    if (!copy) {
+        fprintf(stderr, "Erro de alocação\n");
         exit(EXIT_FAILURE);
     }
+    for (int i = 0; i < argc; i++) {
+        copy[i] = strdup(argv[i]);
+        if (!copy[i]) {
+            fprintf(stderr, "Erro de alocação\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    copy[argc] = NULL;
+    return copy;
+}
+
+// Thread de um estágio builtin; fecha as suas pontas ao terminar (o que dá
+// EOF ao estágio seguinte) e devolve o status de saída
+void* run_stage_builtin(void *arg) {
+    BuiltinStage *b = (BuiltinStage*) arg;
+    int in = b->in_fd != -1 ? b->in_fd : STDIN_FILENO;
+    int out = b->out_fd != -1 ? b->out_fd : STDOUT_FILENO;
+    int err = b->err_fd != -1 ? b->err_fd : STDERR_FILENO;
+    int status = strcmp(b->argv[0], "cat") == 0 ? builtin_cat(b->argv, in, out, err)
+                                               : builtin_tee(b->argv, in, out, err);
+    if (b->in_fd != -1) close(b->in_fd);
+    if (b->out_fd != -1) close(b->out_fd);
+    if (b->err_fd != -1) close(b->err_fd);
+    for (int i = 0; b->argv[i]; i++) free(b->argv[i]);
+    free(b->argv);
+    free(b);
+    notify_main_loop();
+    return (void*) (intptr_t) status;
+}
+
+// Um estágio do pipeline: argv (dentro do vetor de tokens) e redirecionamentos
+typedef struct {
+    char **argv;
+    char *in_file;   // "<" (NULL = stdin herdado ou pipe)
+    char *out_file;  // ">" ou ">>" (NULL = stdout herdado ou pipe)
+    int append;      // out_file veio de ">>"
+    char *err_file;  // "2>"
+} Stage;
+
+static int interactive = 0; // shell no controle do terminal
+static pid_t shell_pgid;
+
+// O estágio builtin lê a entrada do shell? cat só com arquivos não a lê
+int stage_reads_stdin(const Stage *stage) {
+    if (stage->in_file) return 0;
+    if (strcmp(stage->argv[0], "cat") != 0 || stage->argv[1] == NULL) return 1;
+    for (int i = 1; stage->argv[i]; i++) {
+        if (strcmp(stage->argv[i], "-") == 0) return 1;
+    }
+    return 0;
+}
 
-    // Pai fecha ambos os lados do pipe e espera filhos
-    close(fd[0]);
-    close(fd[1]);
-    waitpid(pid1, NULL, 0);
-    waitpid(pid2, NULL, 0);
+int is_redirection(const char *token) {
+    return strcmp(token, "<") == 0 || strcmp(token, ">") == 0 || strcmp(token, ">>") == 0 ||
+           strcmp(token, "2>") == 0;
 }
 
-// Verifica e executa redirecionamentos (<, >)
-void handle_redirection(char **args) {
-    int i = 0;
-    int in_redirect = -1, out_redirect = -1;
+int is_operator(const char *token) {
+    return strcmp(token, "|") == 0 || is_redirection(token);
+}
 
-    while (args[i]) {
-        if (strcmp(args[i], "<") == 0) {
-            in_redirect = i;
-        } else if (strcmp(args[i], ">") == 0) {
-            out_redirect = i;
+// Separa os tokens em estágios (um por '|') e tira os redirecionamentos do
+// argv de cada um. Retorna o número de estágios ou -1 em erro de sintaxe.
+int parse_pipeline(char **args, Stage *stages) {
+    int n = 0;
+    char **cur = args;
+    while (1) {
+        Stage *stage = &stages[n];
+        stage->in_file = stage->out_file = stage->err_file = NULL;
+        stage->append = 0;
+        int i = 0, argc = 0;
+        for (; cur[i] && strcmp(cur[i], "|") != 0; i++) {
+            if (is_redirection(cur[i])) {
+                if (cur[i + 1] == NULL || is_operator(cur[i + 1])) {
+                    fprintf(stderr, "Erro: arquivo esperado após '%s'\n", cur[i]);
+                    return -1;
+                }
+                if (cur[i][0] == '<') {
+                    stage->in_file = cur[i + 1];
+                } else if (cur[i][0] == '2') {
+                    stage->err_file = cur[i + 1];
+                } else {
+                    stage->out_file = cur[i + 1];
+                    stage->append = cur[i][1] == '>';
+                }
+                i++;
+            } else {
+                cur[argc++] = cur[i];
+            }
         }
-        i++;
+        char **next = cur[i] ? &cur[i + 1] : NULL;
+        cur[argc] = NULL;
+        if (argc == 0) {
+            fprintf(stderr, "Erro: comando esperado %s\n", n > 0 || next ? "ao redor de '|'" : "antes do redirecionamento");
+            return -1;
+        }
+        stage->argv = cur;
+        n++;
+        if (!next) return n;
+        cur = next;
     }
+}
 
-    if (in_redirect != -1) {
-        if (args[in_redirect + 1] == NULL) {
-            fprintf(stderr, "Erro: arquivo esperado após '<'\n");
-            return;
+// Lança um estágio com posix_spawn. Na glibc ele usa clone(CLONE_VM |
+// CLONE_VFORK): não copia as tabelas de páginas, então o custo não cresce com
+// a memória do shell como no fork. pgid 0 cria um grupo novo liderado pelo
+// próprio estágio; take_tty faz esse líder pegar o terminal. Retorna o pid ou -1.
+pid_t spawn_stage(char **argv, int in_fd, int out_fd, int err_fd, pid_t pgid, int take_tty) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t defaults;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+#ifdef __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2, 35)
+    // O líder pega o terminal antes do exec: sem corrida com a leitura do tty
+    if (take_tty && pgid == 0) posix_spawn_file_actions_addtcsetpgrp_np(&actions, STDIN_FILENO);
+#endif
+#endif
+    if (in_fd != -1) posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    if (out_fd != -1) posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    if (err_fd != -1) posix_spawn_file_actions_adddup2(&actions, err_fd, STDERR_FILENO);
+    // Sinais que o shell ignora voltam ao padrão nos filhos
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGTTOU);
+    sigaddset(&defaults, SIGTTIN);
+    sigaddset(&defaults, SIGTSTP);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGQUIT);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setpgroup(&attr, pgid);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF);
+
+    // Caminho da tabela de hash; se ele sumiu, procura de novo uma vez
+    pid_t pid;
+    char buf[PATH_MAX];
+    const char *path = resolve_command(argv[0], buf, sizeof(buf));
+    int err = path ? posix_spawn(&pid, path, &actions, &attr, argv, environ) : ENOENT;
+    if (err == ENOENT && path && hash_forget(argv[0])) {
+        path = resolve_command(argv[0], buf, sizeof(buf));
+        err = path ? posix_spawn(&pid, path, &actions, &attr, argv, environ) : ENOENT;
+    }
+    if (err == ENOEXEC) {
+        // Arquivo executável sem "#!": roda com /bin/sh, como fazia o execvp
+        char *sh_argv[MAX_ARGS + 2];
+        int argc = 1;
+        sh_argv[0] = "/bin/sh";
+        sh_argv[1] = (char*) path;
+        for (; argv[argc] && argc < MAX_ARGS; argc++) sh_argv[argc + 1] = argv[argc];
+        sh_argv[argc + 1] = NULL;
+        err = posix_spawn(&pid, "/bin/sh", &actions, &attr, sh_argv, environ);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (!path) {
+        fprintf(stderr, "%s: comando não encontrado\n", argv[0]);
+        return -1;
+    }
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", argv[0], strerror(err));
+        return -1;
+    }
+    return pid;
+}
+
+// Abre o arquivo de um redirecionamento (fechado no exec dos filhos)
+int open_redirection(const char *file, int flags) {
+    int fd = open(file, flags | O_CLOEXEC, 0644);
+    if (fd < 0) perror(file);
+    return fd;
+}
+
+// Redirecionamentos de um builtin que roda no próprio shell: aplica-os aos
+// fds 0-2 e guarda os originais em saved para restore_redirections.
+// Retorna 0, sem mudar nada, se algum arquivo não pôde ser aberto.
+int apply_redirections(const Stage *stage, int saved[3]) {
+    const char *files[3] = { stage->in_file, stage->out_file, stage->err_file };
+    int flags[3] = { O_RDONLY, O_WRONLY | O_CREAT | (stage->append ? O_APPEND : O_TRUNC),
+                     O_WRONLY | O_CREAT | O_TRUNC };
+    int fds[3] = { -1, -1, -1 };
+    for (int i = 0; i < 3; i++) {
+        saved[i] = -1;
+        if (files[i] && (fds[i] = open_redirection(files[i], flags[i])) == -1) {
+            for (int j = 0; j < i; j++) {
+                if (fds[j] != -1) close(fds[j]);
+            }
+            return 0;
         }
-        int fd_in = open(args[in_redirect + 1], O_RDONLY);
-        if (fd_in < 0) {
-            perror("open input");
-            return;
+    }
+    fflush(stdout);
+    for (int i = 0; i < 3; i++) {
+        if (fds[i] == -1) continue;
+        saved[i] = fcntl(i, F_DUPFD_CLOEXEC, 10);
+        dup2(fds[i], i);
+        close(fds[i]);
+    }
+    return 1;
+}
+
+void restore_redirections(int saved[3]) {
+    fflush(stdout);
+    for (int i = 0; i < 3; i++) {
+        if (saved[i] == -1) continue;
+        dup2(saved[i], i);
+        close(saved[i]);
+    }
+}
+
+// Pipeline em execução: processos lançados e threads dos estágios builtin
+typedef struct {
+    pid_t pids[MAX_ARGS];
+    int n_pids;
+    pthread_t threads[MAX_ARGS];
+    int n_threads;
+    pid_t pgid;       // grupo dos processos (0 se nenhum)
+    int owns_tty;     // o grupo recebeu o terminal
+    pid_t last_pid;   // processo do último estágio (0 se não é processo)
+    int last_thread;  // thread do último estágio (-1 se não é thread)
+    int status;       // status do último estágio se ele nem foi lançado
+} Pipeline;
+
+// Lança todos os estágios, ligados por pipes, em um único grupo de processos.
+// Os pipes são O_CLOEXEC: cada filho só herda as pontas que recebe via dup2.
+// cat e tee rodam em threads do shell, que passam a ser donas das suas pontas.
+// Um estágio que falha (arquivo ou comando inexistente) não é lançado e os
+// vizinhos veem EOF/SIGPIPE. Em segundo plano o grupo não recebe o terminal e a
+// entrada vem de /dev/null quando o leitor seria o próprio shell: um script ou
+// o terminal disputado por uma thread de builtin.
+void launch_pipeline(Stage *stages, int n, int background, Pipeline *p) {
+    int in_fd = -1;
+    memset(p, 0, sizeof(*p));
+    p->last_thread = -1;
+    // Se o primeiro estágio é um builtin que lê a entrada, é o shell que lê o
+    // terminal; senão o grupo o recebe e ^C/^Z chegam aos processos
+    int take_tty = interactive && !background &&
+                   !(is_stage_builtin(stages[0].argv) && stage_reads_stdin(&stages[0]));
+    if (background && (!interactive || is_stage_builtin(stages[0].argv)) && !stages[0].in_file) {
+        in_fd = open_redirection("/dev/null", O_RDONLY);
+    }
+    for (int k = 0; k < n; k++) {
+        int fd[2] = { -1, -1 };
+        if (k < n - 1 && pipe2(fd, O_CLOEXEC) == -1) {
+            perror("pipe");
+            break;
+        }
+        // Arquivo redirecionado substitui a ponta do pipe
+        int stage_in = in_fd, stage_out = fd[1], stage_err = -1;
+        int ok = 1, status = 1; // 1: redirecionamento falhou
+
+        if (stages[k].in_file) {
+            if (in_fd != -1) close(in_fd);
+            stage_in = open_redirection(stages[k].in_file, O_RDONLY);
+            ok = stage_in != -1;
         }
-        dup2(fd_in, STDIN_FILENO);
-        close(fd_in);
-        args[in_redirect] = NULL;
+        if (ok && stages[k].out_file) {
+            if (fd[1] != -1) close(fd[1]);
+            fd[1] = -1;
+            stage_out = open_redirection(stages[k].out_file,
+                                         O_WRONLY | O_CREAT | (stages[k].append ? O_APPEND : O_TRUNC));
+            ok = stage_out != -1;
+        }
+        if (ok && stages[k].err_file) {
+            stage_err = open_redirection(stages[k].err_file, O_WRONLY | O_CREAT | O_TRUNC);
+            ok = stage_err != -1;
+        }
+        if (ok && is_stage_builtin(stages[k].argv)) {
+            BuiltinStage *b = malloc(sizeof(BuiltinStage));
+            if (!b) {
+                fprintf(stderr, "Erro de alocação\n");
+                exit(EXIT_FAILURE);
+            }
+            *b = (BuiltinStage) { dup_argv(stages[k].argv), stage_in, stage_out, stage_err };
+            // Em segundo plano a thread herda SIGINT bloqueado: o ^C não é para ela
+            sigset_t block, old;
+            sigemptyset(&block);
+            sigaddset(&block, SIGINT);
+            if (background) pthread_sigmask(SIG_BLOCK, &block, &old);
+            int err = pthread_create(&p->threads[p->n_threads], NULL, run_stage_builtin, b);
+            if (background) pthread_sigmask(SIG_SETMASK, &old, NULL);
+            if (err == 0) {
+                if (k == n - 1) p->last_thread = p->n_threads;
+                p->n_threads++;
+                stage_in = stage_out = stage_err = -1; // agora são da thread
+            } else {
+                fprintf(stderr, "%s: %s\n", stages[k].argv[0], strerror(err));
+                for (int i = 0; b->argv[i]; i++) free(b->argv[i]);
+                free(b->argv);
+                free(b);
+            }
+        } else if (ok && !is_builtin(stages[k].argv)) {
+            // Builtins como cd no meio de um pipeline rodariam em um subshell, sem efeito
+            pid_t pid = spawn_stage(stages[k].argv, stage_in, stage_out, stage_err, p->pgid, take_tty);
+            status = 127; // comando não encontrado
+            if (pid > 0) {
+                if (k == n - 1) p->last_pid = pid;
+                if (p->pgid == 0) {
+                    p->pgid = pid;
+                    p->owns_tty = take_tty;
+                    if (take_tty) tcsetpgrp(STDIN_FILENO, pid);
+                }
+                p->pids[p->n_pids++] = pid;
+            }
+        } else if (ok) {
+            status = 0;
+        }
+        if (k == n - 1) p->status = status;
+        if (stage_in != -1) close(stage_in);
+        if (stage_out != -1) close(stage_out);
+        if (stage_err != -1) close(stage_err);
+        in_fd = fd[0];
     }
+    if (in_fd != -1) close(in_fd);
+}
+
+// Tabela de jobs: todo pipeline vira um job, em primeiro ou segundo plano
+typedef enum { JOB_RUNNING, JOB_STOPPED, JOB_DONE } JobState;
+
+typedef struct {
+    int id;                  // 0 = posição livre
+    char command[MAX_LINE];
+    Pipeline p;
+    int alive;               // processos ainda não recolhidos
+    int threads_alive;       // threads de builtins ainda não terminadas
+    unsigned char joined[MAX_ARGS];
+    JobState state;
+    int status;              // status do último estágio
+    int signalled;           // ^C ou ^\ que terminou um processo do job (0 = nenhum)
+    int notify;              // mudança de estado ainda não mostrada ao usuário
+} Job;
+
+static Job jobs[MAX_JOBS];
+static int last_status = 0; // $?
+
+static const char *job_state_names[] = { "Executando", "Parado", "Concluído" };
+
+// Status no formato do shell: código de saída ou 128 + sinal
+int shell_status(int wstatus) {
+    if (WIFEXITED(wstatus)) return WEXITSTATUS(wstatus);
+    if (WIFSIGNALED(wstatus)) return 128 + WTERMSIG(wstatus);
+    return 128 + WSTOPSIG(wstatus);
+}
 
-    if (out_redirect != -1) {
-        if (args[out_redirect + 1] == NULL) {
-            fprintf(stderr, "Erro: arquivo esperado após '>'\n");
+void check_job_done(Job *job) {
+    if (job->alive == 0 && job->threads_alive == 0 && job->state != JOB_DONE) {
+        // Um cat/tee no fim só vê EOF, mas o sinal era para o grupo todo
+        if (job->p.last_thread != -1 && job->signalled) job->status = 128 + job->signalled;
+        job->state = JOB_DONE;
+        job->notify = 1;
+    }
+}
+
+// Aplica a mudança de estado de um filho ao seu job
+void update_job(pid_t pid, int wstatus) {
+    for (int j = 0; j < MAX_JOBS; j++) {
+        Job *job = &jobs[j];
+        if (job->id == 0) continue;
+        for (int k = 0; k < job->p.n_pids; k++) {
+            if (job->p.pids[k] != pid) continue;
+            if (WIFSTOPPED(wstatus)) {
+                // Cada estágio avisa que parou; basta mostrar uma vez
+                if (job->state != JOB_STOPPED) job->notify = 1;
+                job->state = JOB_STOPPED;
+            } else if (WIFCONTINUED(wstatus)) {
+                job->state = JOB_RUNNING;
+            } else {
+                job->p.pids[k] = 0; // recolhido
+                job->alive--;
+                if (WIFSIGNALED(wstatus) && (WTERMSIG(wstatus) == SIGINT || WTERMSIG(wstatus) == SIGQUIT)) {
+                    job->signalled = WTERMSIG(wstatus);
+                }
+                if (pid == job->p.last_pid) job->status = shell_status(wstatus);
+                check_job_done(job);
+            }
             return;
         }
-        int fd_out = open(args[out_redirect + 1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
-        if (fd_out < 0) {
-            perror("open output");
-            return;
+    }
+}
+
+// Recolhe as threads de builtins do job; block espera por elas
+void join_job_threads(Job *job, int block) {
+    for (int k = 0; k < job->p.n_threads; k++) {
+        if (job->joined[k]) continue;
+        void *ret;
+        int err = block ? pthread_join(job->p.threads[k], &ret) : pthread_tryjoin_np(job->p.threads[k], &ret);
+        if (err != 0) continue;
+        job->joined[k] = 1;
+        job->threads_alive--;
+        if (k == job->p.last_thread) job->status = (int) (intptr_t) ret;
+    }
+    check_job_done(job);
+}
+
+// Recolhe sem bloquear tudo o que mudou desde o último aviso do self-pipe
+void reap_jobs(void) {
+    char buf[256];
+    int pending = 0;
+    while (read(notify_pipe[0], buf, sizeof(buf)) > 0) pending = 1;
+    if (!pending) return;
+    int wstatus;
+    pid_t pid;
+    while ((pid = waitpid(-1, &wstatus, WNOHANG | WUNTRACED | WCONTINUED)) > 0) {
+        update_job(pid, wstatus);
+    }
+    for (int j = 0; j < MAX_JOBS; j++) {
+        if (jobs[j].id != 0 && jobs[j].threads_alive > 0) join_job_threads(&jobs[j], 0);
+    }
+}
+
+void print_job(const Job *job) {
+    printf("[%d] %-10s %s\n", job->id, job_state_names[job->state], job->command);
+}
+
+// Mostra as mudanças de estado pendentes e libera os jobs concluídos
+void notify_jobs(void) {
+    for (int j = 0; j < MAX_JOBS; j++) {
+        Job *job = &jobs[j];
+        if (job->id == 0 || !job->notify) continue;
+        print_job(job);
+        job->notify = 0;
+        if (job->state == JOB_DONE) job->id = 0;
+    }
+}
+
+// Espera o job em primeiro plano terminar ou parar (Ctrl-Z) e atualiza $?.
+// waitpid(-1) também recolhe filhos de jobs em segundo plano que terminarem.
+// O SIGINT fica bloqueado no laço principal durante a espera, para que um ^C
+// seja entregue à thread de um cat/tee do job (que o repassa aos processos
+// quando o terminal ficou com o shell).
+void wait_foreground(Job *job) {
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    if (interactive && !job->p.owns_tty) forward_pgid = job->p.pgid;
+    while (job->state == JOB_RUNNING && job->alive > 0) {
+        int wstatus;
+        pid_t pid = waitpid(-1, &wstatus, WUNTRACED);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
         }
-        dup2(fd_out, STDOUT_FILENO);
-        close(fd_out);
-        args[out_redirect] = NULL;
-    }
-}
-
-// Executa comando considerando redirecionamento e pipe
-void exec_with_redirection_and_pipe(char **args) {
-    int pipe_idx = find_pipe(args);
-    if (pipe_idx == -1) {
-        // Redirecionamento direto
-        pid_t pid = fork();
-        if (pid == 0) {
-            handle_redirection(args);
-            if (is_builtin(args))
-                exec_builtin(args);
-            else
-                execvp(args[0], args);
-            perror("execvp");
-            exit(EXIT_FAILURE);
+        update_job(pid, wstatus);
+    }
+    // Um job parado pode ter threads bloqueadas no pipe: essas ficam para depois
+    if (job->state == JOB_RUNNING) join_job_threads(job, 1);
+    forward_pgid = 0;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    interrupted = 0; // um ^C pendente era deste job
+    if (job->p.owns_tty) tcsetpgrp(STDIN_FILENO, shell_pgid);
+    if (job->state == JOB_STOPPED) {
+        printf("\n");
+        print_job(job);
+        job->notify = 0;
+        last_status = 128 + SIGTSTP;
+    } else {
+        last_status = job->status;
+        job->id = 0;
+        // O ^C ou ^\ ecoado não termina a linha
+        if (last_status == 128 + SIGINT || last_status == 128 + SIGQUIT) printf("\n");
+    }
+}
+
+// Job indicado por "%n" ou "n"; sem argumento, o de maior número
+Job* find_job(const char *spec) {
+    Job *found = NULL;
+    if (spec) {
+        int id = atoi(spec[0] == '%' ? spec + 1 : spec);
+        for (int j = 0; j < MAX_JOBS; j++) {
+            if (jobs[j].id != 0 && jobs[j].id == id) found = &jobs[j];
         }
-        else if (pid < 0) {
-            perror("fork");
+    } else {
+        for (int j = 0; j < MAX_JOBS; j++) {
+            if (jobs[j].id != 0 && jobs[j].state != JOB_DONE && (!found || jobs[j].id > found->id)) found = &jobs[j];
         }
-        else {
-            waitpid(pid, NULL, 0);
+    }
+    if (!found || found->state == JOB_DONE) {
+        fprintf(stderr, "%s: job inexistente\n", spec ? spec : "atual");
+        return NULL;
+    }
+    return found;
+}
+
+// jobs, fg e bg; retorna o status de saída
+int exec_job_builtin(char **args) {
+    if (strcmp(args[0], "jobs") == 0) {
+        for (int j = 0; j < MAX_JOBS; j++) {
+            if (jobs[j].id == 0) continue;
+            print_job(&jobs[j]);
+            jobs[j].notify = 0;
+            if (jobs[j].state == JOB_DONE) jobs[j].id = 0;
         }
-    } else {
-        // Pipeline - só suporta um pipe simples
-        int fd[2];
-        if (pipe(fd) == -1) {
-            perror("pipe");
+        return 0;
+    }
+    Job *job = find_job(args[1]);
+    if (!job) return 1;
+    int foreground = strcmp(args[0], "fg") == 0;
+    printf("%s\n", job->command);
+    if (foreground && interactive && job->p.pgid) {
+        tcsetpgrp(STDIN_FILENO, job->p.pgid);
+        job->p.owns_tty = 1;
+    }
+    if (job->state == JOB_STOPPED && job->p.pgid) kill(-job->p.pgid, SIGCONT);
+    job->state = JOB_RUNNING;
+    if (foreground) {
+        wait_foreground(job);
+        return last_status;
+    }
+    return 0;
+}
+
+// Executa a linha: builtins do shell sozinhos rodam nele mesmo; o resto vira
+// um job. Com '&' no fim, o job fica em segundo plano e o prompt volta na hora.
+void exec_line(char **args, const char *text) {
+    Stage stages[MAX_ARGS];
+    char status_text[16];
+    int argc = 0, background = 0;
+    while (args[argc]) argc++;
+    if (argc > 0 && strcmp(args[argc - 1], "&") == 0) {
+        background = 1;
+        args[--argc] = NULL;
+        if (argc == 0) {
+            fprintf(stderr, "Erro: comando esperado antes de '&'\n");
             return;
         }
+    }
+    // $? como palavra inteira vira o status do último comando
+    snprintf(status_text, sizeof(status_text), "%d", last_status);
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(args[i], "$?") == 0) args[i] = status_text;
+    }
 
-        pid_t pid1 = fork();
-        if (pid1 == 0) {
-            close(fd[0]);
-            dup2(fd[1], STDOUT_FILENO);
-            close(fd[1]);
-            args[pipe_idx] = NULL;
-            handle_redirection(args);
-            if (is_builtin(args))
-                exec_builtin(args);
-            else
-                execvp(args[0], args);
-            perror("execvp");
-            exit(EXIT_FAILURE);
+    int n = parse_pipeline(args, stages);
+    if (n <= 0) {
+        last_status = 2;
+        return;
+    }
+    if (n == 1 && is_builtin(stages[0].argv)) {
+        int saved[3];
+        if (!apply_redirections(&stages[0], saved)) {
+            last_status = 1;
+            return;
         }
+        last_status = is_job_builtin(stages[0].argv) ? exec_job_builtin(stages[0].argv)
+                                                     : exec_builtin(stages[0].argv);
+        restore_redirections(saved);
+        return;
+    }
 
-        pid_t pid2 = fork();
-        if (pid2 == 0) {
-            close(fd[1]);
-            dup2(fd[0], STDIN_FILENO);
-            close(fd[0]);
-            char **right_cmd = &args[pipe_idx + 1];
-            handle_redirection(right_cmd);
-            if (is_builtin(right_cmd))
-                exec_builtin(right_cmd);
-            else
-                execvp(right_cmd[0], right_cmd);
-            perror("execvp");
-            exit(EXIT_FAILURE);
+    Job *job = NULL;
+    int id = 1;
+    for (int j = 0; j < MAX_JOBS; j++) {
+        if (jobs[j].id == 0 && !job) job = &jobs[j];
+        if (jobs[j].id >= id) id = jobs[j].id + 1;
+    }
+    if (!job) {
+        fprintf(stderr, "Erro: limite de %d jobs atingido\n", MAX_JOBS);
+        last_status = 1;
+        return;
+    }
+    interrupted = 0;
+    launch_pipeline(stages, n, background, &job->p);
+    job->alive = job->p.n_pids;
+    job->threads_alive = job->p.n_threads;
+    if (job->alive == 0 && job->threads_alive == 0) {
+        last_status = job->p.status; // nada foi lançado
+        return;
+    }
+    job->id = id;
+    snprintf(job->command, sizeof(job->command), "%s", text);
+    memset(job->joined, 0, sizeof(job->joined));
+    job->state = JOB_RUNNING;
+    job->status = job->p.status;
+    job->signalled = 0;
+    job->notify = 0;
+    if (background) {
+        if (job->p.pgid)
+            printf("[%d] %d\n", job->id, (int) job->p.pgid);
+        else
+            printf("[%d]\n", job->id);
+        last_status = 0;
+    } else {
+        wait_foreground(job);
+    }
+}
+
+// Benchmark (--bench-spawn [MB]): custo de lançar cada estágio de um pipeline
+// de 'true', com posix_spawn e com fork + exec, enquanto a memória tocada
+// pelo shell cresce de 0 até o limite em MB.
+#define BENCH_STAGES 8
+#define BENCH_ROUNDS 50
+
+pid_t fork_stage(char **argv, int in_fd, int out_fd, int err_fd, pid_t pgid, int take_tty) {
+    (void) err_fd;
+    (void) take_tty;
+    pid_t pid = fork();
+    if (pid == 0) {
+        setpgid(0, pgid);
+        if (in_fd != -1) dup2(in_fd, STDIN_FILENO);
+        if (out_fd != -1) dup2(out_fd, STDOUT_FILENO);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+// Microssegundos por estágio na média de BENCH_ROUNDS pipelines
+double bench_launch(pid_t (*launch)(char **, int, int, int, pid_t, int)) {
+    char *argv[] = { "true", NULL };
+    pid_t pids[BENCH_STAGES];
+    double total = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int in_fd = -1;
+        pid_t pgid = 0;
+        for (int k = 0; k < BENCH_STAGES; k++) {
+            int fd[2] = { -1, -1 };
+            if (k < BENCH_STAGES - 1 && pipe2(fd, O_CLOEXEC) == -1) {
+                perror("pipe");
+                exit(EXIT_FAILURE);
+            }
+            pids[k] = launch(argv, in_fd, fd[1], -1, pgid, 0);
+            if (pids[k] < 0) {
+                perror("launch");
+                exit(EXIT_FAILURE);
+            }
+            if (pgid == 0) pgid = pids[k];
+            if (in_fd != -1) close(in_fd);
+            if (fd[1] != -1) close(fd[1]);
+            in_fd = fd[0];
         }
+        // Conta até o fim: com fork o pai volta antes do exec do filho
+        for (int k = 0; k < BENCH_STAGES; k++) waitpid(pids[k], NULL, 0);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        total += (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+    }
+    return total / BENCH_ROUNDS / BENCH_STAGES;
+}
 
-        close(fd[0]);
-        close(fd[1]);
-        waitpid(pid1, NULL, 0);
-        waitpid(pid2, NULL, 0);
+void bench_spawn(int max_mb) {
+    printf("Pipeline de %d estágios 'true', média de %d execuções (us por estágio)\n", BENCH_STAGES, BENCH_ROUNDS);
+    printf("%10s %14s %14s\n", "memória", "posix_spawn", "fork+exec");
+    for (int mb = 0; mb <= max_mb; mb = mb == 0 ? 64 : mb * 2) {
+        // Lastro em páginas pequenas, todas tocadas: como um heap fragmentado,
+        // cada página vira uma entrada que o fork precisa copiar
+        size_t size = (size_t) mb << 20;
+        char *ballast = NULL;
+        if (mb > 0) {
+            ballast = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ballast == MAP_FAILED) {
+                fprintf(stderr, "Erro de alocação\n");
+                exit(EXIT_FAILURE);
+            }
+            madvise(ballast, size, MADV_NOHUGEPAGE);
+            memset(ballast, 1, size);
+        }
+        double spawn_us = bench_launch(spawn_stage);
+        double fork_us = bench_launch(fork_stage);
+        printf("%7d MB %14.1f %14.1f\n", mb, spawn_us, fork_us);
+        if (ballast) munmap(ballast, size);
     }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench-spawn") == 0) {
+        bench_spawn(argc > 2 ? atoi(argv[2]) : 512);
+        return 0;
+    }
+
+    // Controle de terminal só quando o shell está em primeiro plano em um tty
+    shell_pgid = getpgrp();
+    interactive = isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == shell_pgid;
+    if (interactive) {
+        signal(SIGTTOU, SIG_IGN); // para retomar o terminal com tcsetpgrp
+        signal(SIGTTIN, SIG_IGN);
+        signal(SIGTSTP, SIG_IGN); // Ctrl-Z para o job em primeiro plano, não o shell
+        signal(SIGQUIT, SIG_IGN);
+        // ^C não mata o shell: interrompe o prompt ou um cat/tee em primeiro plano
+        struct sigaction sa_int;
+        memset(&sa_int, 0, sizeof(sa_int));
+        sa_int.sa_handler = on_sigint;
+        sigemptyset(&sa_int.sa_mask);
+        sigaction(SIGINT, &sa_int, NULL);
+    }
+    // cat e tee rodam no shell: leitor que sai vira EPIPE, não a morte do shell
+    signal(SIGPIPE, SIG_IGN);
+
+    if (pipe2(notify_pipe, O_CLOEXEC | O_NONBLOCK) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigchld;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGCHLD, &sa, NULL);
+
     while (1) {
+        reap_jobs();
+        notify_jobs();
         printf("mini-shell$ ");
         fflush(stdout);
 
@@ -267,6 +1325,8 @@ int main() {
             continue;
         }
 
+        char text[MAX_LINE];
+        snprintf(text, sizeof(text), "%s", line);
         char *args[MAX_ARGS];
         parse_line(line, args);
 
@@ -281,7 +1341,7 @@ int main() {
             break;
         }
 
-        exec_with_redirection_and_pipe(args);
+        exec_line(args, text);
 
         free(line);
     }
@@ -1,209 +1,2459 @@
+// Compilar com: gcc simuladorescalonamentodeprocessos.c -o simulador -lm -pthread
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <sys/resource.h>
+#include <ucontext.h>
+
+#define MLFQ_MAX_LEVELS 8        // Máximo de níveis da MLFQ
+#define CFS_LATENCY 24           // Período em que todos os prontos devem rodar (CFS)
+#define CFS_MIN_GRANULARITY 3    // Fatia mínima do CFS
+#define TRACE_BUF_SIZE (64 * 1024) // Bloco de leitura dos traces
+#define TRACE_MAGIC "SCHT1"      // Cabeçalho do formato binário de trace
+#define TRACE_MAGIC_IO "SCHT2"   // Idem, com rajadas de E/S
+#define IO_MAX_BURSTS 64         // Rajadas de E/S por processo (trace e gerador)
+#define BENCH_SEED 42            // Semente dos workloads do --bench
+#define BENCH_RATE 0.09          // Chegadas por unidade de tempo (utilização ~90%)
+#define BENCH_QUANTUM 4          // Quantum de rr, mlfq, smp e rrio no --bench
+#define BENCH_CPUS 4             // CPUs do smp no --bench
+#define BENCH_MIN_MS 200.0       // Workloads rápidos repetem até somar isso
+#define REAL_MAX_PROCESSES 4096  // Limite de fibras no modo --real
+#define REAL_STACK_SIZE (64 * 1024) // Pilha de cada fibra
+#define REAL_CHECKS_PER_UNIT 10  // Pontos de preempção por unidade de trabalho
+#define REAL_CALIBRATION_MS 50   // Duração da calibração do trabalho de CPU
+#define GEN_MAX_BURST 10000000   // Limite dos bursts gerados (cauda pesada)
+#define SWEEP_MAX_VALUES 64      // Valores por dimensão da grade do sweep
+#define SWEEP_MLFQ_LEVELS 3      // Níveis da MLFQ no sweep (quantum dobra por nível)
+#define SWEEP_AGING 10           // Aging da prioridade no sweep (padrão do menu)
+#define SKETCH_ALPHA 0.01        // Erro relativo dos quantis (p50/p95/p99)
+#define SKETCH_BUCKETS 1100      // Baldes do sketch: cobre valores até INT_MAX
+#define METRICS_ROW_LIMIT 100    // Acima disso, print_metrics mostra só o resumo
+#define EVENT_BUF_SIZE (64 * 1024) // Buffer de escrita do log de eventos
+#define EVENT_MAGIC "SCHE1"      // Cabeçalho do log binário de eventos
 
 typedef enum { NEW, READY, RUNNING, WAITING, TERMINATED } ProcessState;
 
-// Estrutura que representa um processo com suas informações e métricas
-typedef struct Process {
-    int pid;
-    int burst_time;
-    int arrival_time;
-    int priority;
-    int remaining_time;
-    ProcessState state;
-    int start_time;
-    int completion_time;
-    int waiting_time;
-    int turnaround_time;
-    int response_time;
-} Process;
-
-// Cria um novo processo inicializando seus campos e definindo estado NEW
-Process* create_process(int pid, int burst_time, int arrival_time, int priority) {
-    Process* proc = (Process*) malloc(sizeof(Process));
-    if (!proc) {
-        printf("Erro ao alocar memória para processo.\n");
+// Saída das simulações: 0 imprime tudo, 1 (--quiet) omite a linha do tempo
+// e 2 (modo sweep) omite também as métricas. Definida antes de as threads do
+// sweep começarem, então não precisa de sincronização.
+static int quiet = 0;
+#define sim_printf(...) do { if (!quiet) printf(__VA_ARGS__); } while (0)
+#define summary_printf(...) do { if (quiet < 2) printf(__VA_ARGS__); } while (0)
+
+static int* alloc_ints(int n) {
+    int *v = (int*) malloc(n * sizeof(int));
+    if (!v) {
+        printf("Erro ao alocar memória para a simulação.\n");
+        exit(EXIT_FAILURE);
+    }
+    return v;
+}
+
+// Workload em colunas (structure of arrays): cada campo dos processos fica em
+// um vetor contíguo e todos os vetores dividem uma única alocação. As
+// simulações percorrem só as colunas de que precisam, sem seguir um ponteiro
+// por processo.
+// Um processo com E/S alterna rajadas cpu0, es0, cpu1, ..., cpuk, guardadas
+// em phases[phase_first .. phase_first + phase_count); burst é a soma das
+// rajadas de CPU. Sem E/S, phase_count = 0. Só io_round_robin simula as
+// rajadas de E/S; os outros algoritmos veem apenas o total de CPU.
+typedef struct {
+    int n, cap;
+    void *block;
+    // Entrada
+    int *pid, *arrival, *burst, *priority, *phase_first, *phase_count;
+    // Estado e métricas da simulação
+    int *remaining, *start, *completion, *waiting, *turnaround, *response;
+    unsigned char *state;   // ProcessState
+    // Rajadas de todos os processos com E/S (alocação própria)
+    int *phases;
+    int n_phases, phase_cap;
+} Workload;
+
+#define WORKLOAD_INT_COLUMNS 12
+
+// Aponta as colunas para um bloco com espaço para cap processos
+static void workload_layout(Workload *w, void *block, int cap) {
+    int **columns[WORKLOAD_INT_COLUMNS] = {
+        &w->pid, &w->arrival, &w->burst, &w->priority, &w->phase_first, &w->phase_count,
+        &w->remaining, &w->start, &w->completion, &w->waiting, &w->turnaround, &w->response
+    };
+    int *next = (int*) block;
+    for (int c = 0; c < WORKLOAD_INT_COLUMNS; c++) {
+        *columns[c] = next;
+        next += cap;
+    }
+    w->state = (unsigned char*) next;
+    w->block = block;
+    w->cap = cap;
+}
+
+// Garante espaço para cap processos, copiando as colunas para o bloco novo
+static void workload_reserve(Workload *w, int cap) {
+    if (cap <= w->cap) return;
+    void *block = malloc((size_t) cap * (WORKLOAD_INT_COLUMNS * sizeof(int) + 1));
+    if (!block) {
+        printf("Erro ao alocar memória para processo.\n");
+        exit(EXIT_FAILURE);
+    }
+    Workload old = *w;
+    workload_layout(w, block, cap);
+    if (old.block) {
+        // Coluna a coluna: o deslocamento de cada uma depende de cap
+        int *from = (int*) old.block, *to = (int*) block;
+        for (int c = 0; c < WORKLOAD_INT_COLUMNS; c++) {
+            memcpy(to + (size_t) c * cap, from + (size_t) c * old.cap, old.n * sizeof(int));
+        }
+        memcpy(w->state, old.state, old.n);
+        free(old.block);
+    }
+}
+
+// Acrescenta um processo, inicializando seus campos e definindo estado NEW
+void add_process(Workload *w, int pid, int burst_time, int arrival_time, int priority) {
+    if (w->n == w->cap) workload_reserve(w, w->cap ? w->cap * 2 : 64);
+    int i = w->n++;
+    w->pid[i] = pid;
+    w->burst[i] = burst_time;
+    w->arrival[i] = arrival_time;
+    w->priority[i] = priority;
+    w->phase_first[i] = 0;
+    w->phase_count[i] = 0;
+    w->remaining[i] = burst_time;
+    w->state[i] = NEW;
+    w->start[i] = -1;      // Ainda não executou
+    w->completion[i] = 0;
+    w->waiting[i] = 0;
+    w->turnaround[i] = 0;
+    w->response[i] = -1;   // Ainda não respondeu
+}
+
+// Define as rajadas (cpu0, es0, ..., cpuk; count ímpar) do último processo
+// e recalcula seu burst como o total de CPU
+void set_last_phases(Workload *w, const int *phases, int count) {
+    if (w->n_phases + count > w->phase_cap) {
+        int cap = w->phase_cap ? w->phase_cap : 256;
+        while (cap < w->n_phases + count) cap *= 2;
+        int *grown = (int*) realloc(w->phases, cap * sizeof(int));
+        if (!grown) {
+            printf("Erro ao alocar memória para processo.\n");
+            exit(EXIT_FAILURE);
+        }
+        w->phases = grown;
+        w->phase_cap = cap;
+    }
+    int i = w->n - 1, cpu = 0;
+    memcpy(w->phases + w->n_phases, phases, count * sizeof(int));
+    for (int k = 0; k < count; k += 2) cpu += phases[k];
+    w->phase_first[i] = w->n_phases;
+    w->phase_count[i] = count;
+    w->burst[i] = w->remaining[i] = cpu;
+    w->n_phases += count;
+}
+
+void free_workload(Workload *w) {
+    free(w->block);
+    free(w->phases);
+    memset(w, 0, sizeof(*w));
+}
+
+// Volta os processos ao estado inicial para simular o mesmo workload de novo
+void reset_workload(Workload *w) {
+    for (int i = 0; i < w->n; i++) {
+        w->remaining[i] = w->burst[i];
+        w->start[i] = -1;
+        w->completion[i] = 0;
+        w->waiting[i] = 0;
+        w->turnaround[i] = 0;
+        w->response[i] = -1;
+    }
+    memset(w->state, NEW, w->n);
+}
+
+// Cópia independente (uma alocação) de src, para simulações em paralelo
+void copy_workload(Workload *dst, const Workload *src) {
+    memset(dst, 0, sizeof(*dst));
+    workload_reserve(dst, src->n > 0 ? src->n : 1);
+    dst->n = src->n;
+    const int *from[WORKLOAD_INT_COLUMNS] = {
+        src->pid, src->arrival, src->burst, src->priority, src->phase_first, src->phase_count,
+        src->remaining, src->start, src->completion, src->waiting, src->turnaround, src->response
+    };
+    int *to[WORKLOAD_INT_COLUMNS] = {
+        dst->pid, dst->arrival, dst->burst, dst->priority, dst->phase_first, dst->phase_count,
+        dst->remaining, dst->start, dst->completion, dst->waiting, dst->turnaround, dst->response
+    };
+    for (int c = 0; c < WORKLOAD_INT_COLUMNS; c++) {
+        memcpy(to[c], from[c], src->n * sizeof(int));
+    }
+    memcpy(dst->state, src->state, src->n);
+    if (src->n_phases > 0) {
+        dst->phases = alloc_ints(src->n_phases);
+        memcpy(dst->phases, src->phases, src->n_phases * sizeof(int));
+        dst->n_phases = dst->phase_cap = src->n_phases;
+    }
+}
+
+// Sketch de quantis com erro relativo de SKETCH_ALPHA (no estilo do
+// DDSketch): um valor v > 0 cai no balde ceil(log_gamma(v)), com
+// gamma = (1 + alfa) / (1 - alfa). Memória fixa, independente de n.
+typedef struct {
+    long long zero;                       // valores <= 0
+    long long buckets[SKETCH_BUCKETS];
+    long long count;
+    double sum;
+    int min, max;
+} QuantileSketch;
+
+static double sketch_gamma(void) {
+    return (1 + SKETCH_ALPHA) / (1 - SKETCH_ALPHA);
+}
+
+static void sketch_add(QuantileSketch *s, int v, double log_gamma) {
+    if (s->count == 0 || v < s->min) s->min = v;
+    if (s->count == 0 || v > s->max) s->max = v;
+    s->count++;
+    s->sum += v;
+    if (v <= 0) {
+        s->zero++;
+        return;
+    }
+    int b = (int) ceil(log((double) v) / log_gamma);
+    if (b >= SKETCH_BUCKETS) b = SKETCH_BUCKETS - 1;
+    s->buckets[b]++;
+}
+
+static double sketch_quantile(const QuantileSketch *s, double q) {
+    if (s->count == 0) return 0;
+    long long rank = (long long) (q * (s->count - 1));
+    if (rank < s->zero) return s->min < 0 ? s->min : 0;
+    long long seen = s->zero;
+    double gamma = sketch_gamma();
+    for (int b = 0; b < SKETCH_BUCKETS; b++) {
+        seen += s->buckets[b];
+        if (rank < seen) {
+            double v = 2 * pow(gamma, b) / (gamma + 1); // centro do balde
+            if (v < s->min) v = s->min;
+            if (v > s->max) v = s->max;
+            return v;
+        }
+    }
+    return s->max;
+}
+
+// Média e quantis de uma métrica
+typedef struct {
+    double mean, p50, p95, p99;
+} MetricStats;
+
+// Resultado agregado de uma simulação concluída
+typedef struct {
+    MetricStats wait, turnaround, response;
+    int makespan;
+} Summary;
+
+static void sketch_stats(const QuantileSketch *s, MetricStats *out) {
+    out->mean = s->count ? s->sum / s->count : 0;
+    out->p50 = sketch_quantile(s, 0.50);
+    out->p95 = sketch_quantile(s, 0.95);
+    out->p99 = sketch_quantile(s, 0.99);
+}
+
+// Agrega as métricas em uma passada pelas colunas, em memória constante
+void summarize(const Workload *w, Summary *out) {
+    QuantileSketch *s = (QuantileSketch*) calloc(3, sizeof(QuantileSketch));
+    if (!s) {
+        printf("Erro ao alocar memória para as métricas.\n");
+        exit(EXIT_FAILURE);
+    }
+    double log_gamma = log(sketch_gamma());
+    int makespan = 0;
+    for (int i = 0; i < w->n; i++) {
+        sketch_add(&s[0], w->waiting[i], log_gamma);
+        sketch_add(&s[1], w->turnaround[i], log_gamma);
+        sketch_add(&s[2], w->response[i] == -1 ? 0 : w->response[i], log_gamma);
+        if (w->completion[i] > makespan) makespan = w->completion[i];
+    }
+    sketch_stats(&s[0], &out->wait);
+    sketch_stats(&s[1], &out->turnaround);
+    sketch_stats(&s[2], &out->response);
+    out->makespan = makespan;
+    free(s);
+}
+
+// Imprime as métricas após a simulação para análise e comparação. A tabela
+// por processo só aparece em workloads pequenos; o resumo traz média e
+// quantis (aproximados em até SKETCH_ALPHA).
+void print_metrics(const Workload *w) {
+    if (quiet > 1) return;
+    if (!quiet && w->n <= METRICS_ROW_LIMIT) {
+        printf("\nPID\tBurst\tArrival\tWait\tTurnaround\tResponse\n");
+        for (int i = 0; i < w->n; i++) {
+            printf("%d\t%d\t%d\t%d\t%d\t\t%d\n",
+                w->pid[i], w->burst[i], w->arrival[i],
+                w->waiting[i], w->turnaround[i], w->response[i]);
+        }
+    }
+    Summary sum;
+    summarize(w, &sum);
+    const char *names[] = { "Espera", "Turnaround", "Resposta" };
+    const MetricStats *stats[] = { &sum.wait, &sum.turnaround, &sum.response };
+    printf("\nMétricas (%d processos, makespan %d):\n", w->n, sum.makespan);
+    printf("%-12s%13s%12s%12s%12s\n", "", "Média", "p50", "p95", "p99"); // "é" ocupa 2 bytes
+    for (int m = 0; m < 3; m++) {
+        printf("%-12s%12.2f%12.0f%12.0f%12.0f\n", names[m],
+               stats[m]->mean, stats[m]->p50, stats[m]->p95, stats[m]->p99);
+    }
+}
+
+// Inteiros com sinal em zigzag (pequenos em módulo viram varints curtos)
+static uint64_t zigzag(int64_t v) { return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63); }
+static int64_t unzigzag(uint64_t v) { return (int64_t) (v >> 1) ^ -(int64_t) (v & 1); }
+
+// Log binário de eventos (--log), lido pelo visualizadorgantt.c. Formato:
+// EVENT_MAGIC seguido de registros, cada um com um byte de tipo e varints:
+//   'B' cpus, tamanho, nome     início de uma simulação (zera a base de tempo)
+//   'R' cpu, pid, início, dur.  fatia de execução
+//   'F' pid, tempo              término de um processo
+//   'M' pid, origem, destino, tempo   migração entre CPUs
+//   'E'                         fim da simulação
+// Tempos são diferenças (zigzag) para o fim do registro anterior. Fatias
+// contíguas do mesmo processo na mesma CPU viram um registro só (run-length),
+// então um 'R' pode vir depois do 'F' do seu processo.
+typedef struct {
+    FILE *file;
+    unsigned char buf[EVENT_BUF_SIZE];
+    size_t len;
+    int64_t last;          // base dos deltas de tempo
+    int cpus;
+    int *run_pid;          // fatia em aberto por CPU (-1 = nenhuma)
+    int64_t *run_start, *run_end;
+    int failed;
+} EventLog;
+
+static EventLog *event_log = NULL;
+
+// Eventos simulados (fatias e términos) pela thread atual; o --bench divide
+// pelo tempo de execução para medir a vazão do simulador
+static __thread long long sim_events = 0;
+
+static void log_flush(EventLog *log) {
+    if (log->len > 0 && fwrite(log->buf, 1, log->len, log->file) != log->len) log->failed = 1;
+    log->len = 0;
+}
+
+static void log_byte(EventLog *log, unsigned char b) {
+    if (log->len == sizeof(log->buf)) log_flush(log);
+    log->buf[log->len++] = b;
+}
+
+static void log_varint(EventLog *log, uint64_t v) {
+    do {
+        log_byte(log, (v & 0x7f) | (v >> 7 ? 0x80 : 0));
+        v >>= 7;
+    } while (v);
+}
+
+static void log_time(EventLog *log, int64_t time) {
+    log_varint(log, zigzag(time - log->last));
+    log->last = time;
+}
+
+// Grava a fatia em aberto da CPU c
+static void log_close_run(EventLog *log, int c) {
+    if (log->run_pid[c] == -1) return;
+    log_byte(log, 'R');
+    log_varint(log, c);
+    log_varint(log, log->run_pid[c]);
+    log_time(log, log->run_start[c]);
+    log_varint(log, log->run_end[c] - log->run_start[c]);
+    log->last = log->run_end[c];
+    log->run_pid[c] = -1;
+}
+
+int open_event_log(const char *filename) {
+    event_log = (EventLog*) calloc(1, sizeof(EventLog));
+    if (!event_log) {
+        printf("Erro ao alocar memória para o log.\n");
+        exit(EXIT_FAILURE);
+    }
+    event_log->file = fopen(filename, "wb");
+    if (!event_log->file) {
+        printf("Não foi possível criar o log %s.\n", filename);
+        free(event_log);
+        event_log = NULL;
+        return 0;
+    }
+    memcpy(event_log->buf, EVENT_MAGIC, sizeof(EVENT_MAGIC) - 1);
+    event_log->len = sizeof(EVENT_MAGIC) - 1;
+    return 1;
+}
+
+int close_event_log(void) {
+    if (!event_log) return 1;
+    log_flush(event_log);
+    int ok = !event_log->failed && fclose(event_log->file) == 0;
+    if (!ok) printf("Erro ao gravar o log de eventos.\n");
+    free(event_log->run_pid);
+    free(event_log->run_start);
+    free(event_log->run_end);
+    free(event_log);
+    event_log = NULL;
+    return ok;
+}
+
+static void log_begin(int cpus, const char *format, ...) {
+    EventLog *log = event_log;
+    if (!log) return;
+    char name[128];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(name, sizeof(name), format, args);
+    va_end(args);
+    free(log->run_pid);
+    free(log->run_start);
+    free(log->run_end);
+    log->run_pid = (int*) malloc(cpus * sizeof(int));
+    log->run_start = (int64_t*) malloc(cpus * sizeof(int64_t));
+    log->run_end = (int64_t*) malloc(cpus * sizeof(int64_t));
+    if (!log->run_pid || !log->run_start || !log->run_end) {
+        printf("Erro ao alocar memória para o log.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < cpus; c++) log->run_pid[c] = -1;
+    log->cpus = cpus;
+    log->last = 0;
+    size_t len = strlen(name);
+    log_byte(log, 'B');
+    log_varint(log, cpus);
+    log_varint(log, len);
+    for (size_t i = 0; i < len; i++) log_byte(log, (unsigned char) name[i]);
+}
+
+static void log_run(int cpu, int pid, int64_t start, int64_t end) {
+    sim_events++;
+    EventLog *log = event_log;
+    if (!log || end <= start) return;
+    if (log->run_pid[cpu] == pid && log->run_end[cpu] == start) {
+        log->run_end[cpu] = end; // continua a fatia anterior
+        return;
+    }
+    log_close_run(log, cpu);
+    log->run_pid[cpu] = pid;
+    log->run_start[cpu] = start;
+    log->run_end[cpu] = end;
+}
+
+static void log_finish(int pid, int64_t time) {
+    sim_events++;
+    EventLog *log = event_log;
+    if (!log) return;
+    log_byte(log, 'F');
+    log_varint(log, pid);
+    log_time(log, time);
+}
+
+static void log_migrate(int pid, int from, int to, int64_t time) {
+    EventLog *log = event_log;
+    if (!log) return;
+    log_byte(log, 'M');
+    log_varint(log, pid);
+    log_varint(log, from);
+    log_varint(log, to);
+    log_time(log, time);
+}
+
+static void log_end(void) {
+    EventLog *log = event_log;
+    if (!log) return;
+    for (int c = 0; c < log->cpus; c++) log_close_run(log, c);
+    log_byte(log, 'E');
+    log_flush(log);
+}
+
+// Escalonamento FCFS (First-Come, First-Served)
+void fcfs(Workload *w) {
+    int time = 0;
+    summary_printf("\nExecutando Escalonamento FCFS:\n");
+    log_begin(1, "FCFS");
+    for (int i = 0; i < w->n; i++) {
+        if (time < w->arrival[i]) time = w->arrival[i]; // Espera o processo chegar
+        w->start[i] = time;
+        w->waiting[i] = time - w->arrival[i];
+        w->response[i] = w->waiting[i];
+        w->completion[i] = time + w->burst[i];
+        w->turnaround[i] = w->completion[i] - w->arrival[i];
+        w->state[i] = TERMINATED;
+        sim_printf("Processo %d executando de %d a %d\n", w->pid[i], w->start[i], w->completion[i]);
+        log_run(0, w->pid[i], w->start[i], w->completion[i]);
+        log_finish(w->pid[i], w->completion[i]);
+        time += w->burst[i];
+    }
+    log_end();
+    print_metrics(w);
+}
+
+// Fila de prontos como min-heap de índices de processos, ordenada por key[i]
+// (empate: menor índice, como na varredura linear original)
+typedef struct {
+    int *items;
+    int size;
+    const int *key;
+} ReadyHeap;
+
+static int heap_less(const ReadyHeap *h, int a, int b) {
+    return h->key[a] < h->key[b] || (h->key[a] == h->key[b] && a < b);
+}
+
+static void heap_push(ReadyHeap *h, int idx) {
+    int i = h->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap_less(h, idx, h->items[parent])) break;
+        h->items[i] = h->items[parent];
+        i = parent;
+    }
+    h->items[i] = idx;
+}
+
+static int heap_pop(ReadyHeap *h) {
+    int top = h->items[0];
+    int last = h->items[--h->size];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && heap_less(h, h->items[child + 1], h->items[child])) child++;
+        if (!heap_less(h, h->items[child], last)) break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->size > 0) h->items[i] = last;
+    return top;
+}
+
+// Ordem de chegada: índices ordenados por tempo de chegada (empate: índice).
+// Ordena pares (chegada, índice) para não depender de estado global, já que
+// o sweep roda várias simulações em paralelo.
+typedef struct {
+    int arrival, index;
+} ArrivalKey;
+
+static int cmp_arrival(const void *a, const void *b) {
+    const ArrivalKey *x = (const ArrivalKey*) a, *y = (const ArrivalKey*) b;
+    if (x->arrival != y->arrival) return x->arrival < y->arrival ? -1 : 1;
+    return x->index < y->index ? -1 : (x->index > y->index);
+}
+
+int* arrival_order(const Workload *w) {
+    int n = w->n;
+    int *order = (int*) malloc(n * sizeof(int));
+    ArrivalKey *keys = (ArrivalKey*) malloc(n * sizeof(ArrivalKey));
+    if (!order || !keys) {
+        printf("Erro ao alocar memória para a simulação.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        keys[i].arrival = w->arrival[i];
+        keys[i].index = i;
+    }
+    qsort(keys, n, sizeof(ArrivalKey), cmp_arrival);
+    for (int i = 0; i < n; i++) order[i] = keys[i].index;
+    free(keys);
+    return order;
+}
+
+// Registra o término de um processo e calcula suas métricas
+static void complete_process(Workload *w, int i, int time) {
+    w->completion[i] = time;
+    w->turnaround[i] = time - w->arrival[i];
+    w->waiting[i] = w->turnaround[i] - w->burst[i];
+    w->state[i] = TERMINATED;
+    sim_printf("Processo %d finalizado em %d\n", w->pid[i], time);
+    log_finish(w->pid[i], time);
+}
+
+// Primeira execução do processo: define início e tempo de resposta
+static void dispatch_process(Workload *w, int i, int time) {
+    if (w->response[i] == -1) {
+        w->start[i] = time;
+        w->response[i] = time - w->arrival[i];
+    }
+}
+
+// Escalonamento SJF preemptivo (Shortest Remaining Time First), por eventos:
+// o tempo salta direto para a próxima chegada ou término, e a fila de prontos
+// é um heap pelo tempo restante. O(n log n) em vez de O(soma dos bursts * n).
+void sjf_preemptive(Workload *w) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    int *remaining = w->remaining;
+    int *order = arrival_order(w);
+    ReadyHeap ready = { (int*) malloc(n * sizeof(int)), 0, remaining };
+    if (!ready.items) {
+        printf("Erro ao alocar memória para a simulação.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < n; i++) {
+        remaining[i] = w->burst[i];
+        w->response[i] = -1;
+    }
+
+    summary_printf("\nExecutando Escalonamento SJF Preemptivo:\n");
+    log_begin(1, "SJF Preemptivo");
+
+    while (completed < n) {
+        if (ready.size == 0 && time < w->arrival[order[next]]) {
+            time = w->arrival[order[next]]; // CPU ociosa até a próxima chegada
+        }
+        while (next < n && w->arrival[order[next]] <= time) {
+            heap_push(&ready, order[next++]);
+        }
+
+        // Processo com menor tempo restante roda até terminar ou até uma
+        // chegada com tempo restante menor tomar a CPU
+        int cur = heap_pop(&ready);
+        int start = time;
+        dispatch_process(w, cur, time);
+        for (;;) {
+            int finish = time + remaining[cur];
+            if (next == n || w->arrival[order[next]] >= finish) {
+                remaining[cur] = 0;
+                time = finish;
+                break;
+            }
+            int arrival = w->arrival[order[next]];
+            remaining[cur] -= arrival - time;
+            time = arrival;
+            while (next < n && w->arrival[order[next]] <= time) {
+                heap_push(&ready, order[next++]);
+            }
+            if (heap_less(&ready, ready.items[0], cur)) break; // preempção
+        }
+
+        sim_printf("Tempo %d a %d executando processo %d\n", start, time, w->pid[cur]);
+        log_run(0, w->pid[cur], start, time);
+        if (remaining[cur] > 0) {
+            heap_push(&ready, cur);
+            continue;
+        }
+        completed++;
+        complete_process(w, cur, time);
+    }
+    log_end();
+    print_metrics(w);
+    free(order);
+    free(ready.items);
+}
+
+// Escalonamento Round Robin com quantum configurável e preempção. A fila de
+// prontos é um buffer circular de n posições (cada processo está nela no
+// máximo uma vez) e as chegadas são consumidas em ordem por um cursor.
+void round_robin(Workload *w, int quantum) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    int *remaining = w->remaining;
+    int *order = arrival_order(w);
+    int *queue = (int*) malloc(n * sizeof(int)); // fila circular
+    int front = 0, count = 0;
+    if (!queue) {
+        printf("Erro ao alocar memória para a simulação.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i=0; i<n; i++) {
+        remaining[i] = w->burst[i];
+        w->response[i] = -1;
+    }
+
+    summary_printf("\nExecutando Escalonamento Round Robin (quantum = %d):\n", quantum);
+    log_begin(1, "Round Robin (quantum = %d)", quantum);
+
+    while (completed < n) {
+        if (count == 0 && time < w->arrival[order[next]]) {
+            time = w->arrival[order[next]]; // fila vazia, salta para a próxima chegada
+        }
+        // Enfileira processos que chegaram (inclusive durante a última fatia)
+        while (next < n && w->arrival[order[next]] <= time) {
+            int i = order[next++];
+            queue[(front + count++) % n] = i;
+            w->response[i] = time - w->arrival[i];
+            w->start[i] = time;
+        }
+
+        int idx = queue[front];
+        front = (front + 1) % n;
+        count--;
+        int exec_time = (remaining[idx] > quantum) ? quantum : remaining[idx];
+        sim_printf("Tempo %d executando processo %d por %d unidades\n", time, w->pid[idx], exec_time);
+        log_run(0, w->pid[idx], time, time + exec_time);
+        remaining[idx] -= exec_time;
+        time += exec_time;
+
+        // Processos que chegaram durante a fatia entram na fila antes do atual
+        while (next < n && w->arrival[order[next]] <= time) {
+            int i = order[next++];
+            queue[(front + count++) % n] = i;
+            w->response[i] = time - w->arrival[i];
+            w->start[i] = time;
+        }
+
+        if (remaining[idx] > 0) {
+            queue[(front + count++) % n] = idx; // Reinsere caso não tenha terminado
+        }
+        else {
+            completed++;
+            complete_process(w, idx, time);
+        }
+    }
+    log_end();
+    print_metrics(w);
+    free(order);
+    free(queue);
+}
+
+// Escalonamento por prioridade (menor valor = maior prioridade) com aging.
+// Cada aging unidades de espera na fila valem um nível de prioridade: a
+// chave de um processo pronto é priority * aging + instante em que entrou na
+// fila, o que mantém a ordem do heap fixa enquanto todos envelhecem juntos.
+// No modo preemptivo, uma chegada com chave menor que a do processo em
+// execução (a que ele tinha na fila) toma a CPU.
+void priority_scheduling(Workload *w, int preemptive, int aging) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    int *remaining = w->remaining;
+    int *key = alloc_ints(n);
+    int *order = arrival_order(w);
+    ReadyHeap ready = { alloc_ints(n), 0, key };
+
+    for (int i = 0; i < n; i++) {
+        remaining[i] = w->burst[i];
+        w->response[i] = -1;
+    }
+
+    summary_printf("\nExecutando Escalonamento por Prioridade %s (aging = %d):\n",
+           preemptive ? "Preemptivo" : "Não Preemptivo", aging);
+    log_begin(1, "Prioridade %s (aging = %d)", preemptive ? "Preemptivo" : "Não Preemptivo", aging);
+
+    while (completed < n) {
+        if (ready.size == 0 && time < w->arrival[order[next]]) {
+            time = w->arrival[order[next]];
+        }
+        while (next < n && w->arrival[order[next]] <= time) {
+            int i = order[next++];
+            key[i] = w->priority[i] * aging + w->arrival[i];
+            heap_push(&ready, i);
+        }
+
+        int cur = heap_pop(&ready);
+        int start = time;
+        dispatch_process(w, cur, time);
+        int finish = time + remaining[cur];
+        time = finish;
+        if (preemptive) {
+            // A primeira chegada que vence o processo atual o interrompe
+            for (int k = next; k < n && w->arrival[order[k]] < finish; k++) {
+                int i = order[k];
+                int arrival = w->arrival[i];
+                if (w->priority[i] * aging + arrival < key[cur] ||
+                    (w->priority[i] * aging + arrival == key[cur] && i < cur)) {
+                    time = arrival;
+                    break;
+                }
+            }
+        }
+        remaining[cur] -= time - start;
+
+        sim_printf("Tempo %d a %d executando processo %d\n", start, time, w->pid[cur]);
+        log_run(0, w->pid[cur], start, time);
+        if (remaining[cur] > 0) {
+            // Chegadas até agora entram antes; o interrompido volta com chave nova
+            while (next < n && w->arrival[order[next]] <= time) {
+                int i = order[next++];
+                key[i] = w->priority[i] * aging + w->arrival[i];
+                heap_push(&ready, i);
+            }
+            key[cur] = w->priority[cur] * aging + time;
+            heap_push(&ready, cur);
+            continue;
+        }
+        completed++;
+        complete_process(w, cur, time);
+    }
+    log_end();
+    print_metrics(w);
+    free(key);
+    free(order);
+    free(ready.items);
+}
+
+// Multi-level feedback queue: levels filas round robin, cada uma com seu
+// quantum. Processos novos entram no nível 0; quem esgota o quantum desce um
+// nível. Uma chegada interrompe um processo de nível inferior (que fica no
+// mesmo nível). A cada boost unidades de tempo (0 = nunca) todos voltam ao
+// nível 0, para que os processos longos não morram de fome.
+void mlfq(Workload *w, int levels, const int *quanta, int boost) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    int next_boost = boost;
+    int *remaining = w->remaining;
+    int *level = alloc_ints(n);
+    int *order = arrival_order(w);
+    int *queue[MLFQ_MAX_LEVELS];   // filas circulares de n posições por nível
+    int front[MLFQ_MAX_LEVELS], count[MLFQ_MAX_LEVELS];
+
+    for (int l = 0; l < levels; l++) {
+        queue[l] = alloc_ints(n);
+        front[l] = count[l] = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        remaining[i] = w->burst[i];
+        w->response[i] = -1;
+    }
+
+    summary_printf("\nExecutando Escalonamento MLFQ (%d níveis, boost = %d):\n", levels, boost);
+    log_begin(1, "MLFQ (%d níveis, boost = %d)", levels, boost);
+
+    while (completed < n) {
+        int l = 0;
+        while (l < levels && count[l] == 0) l++;
+        if (l == levels && time < w->arrival[order[next]]) {
+            time = w->arrival[order[next]];
+        }
+        while (next < n && w->arrival[order[next]] <= time) {
+            int i = order[next++];
+            level[i] = 0;
+            queue[0][(front[0] + count[0]++) % n] = i;
+        }
+        l = 0;
+        while (count[l] == 0) l++;
+
+        int idx = queue[l][front[l]];
+        front[l] = (front[l] + 1) % n;
+        count[l]--;
+        dispatch_process(w, idx, time);
+
+        int start = time;
+        int slice = remaining[idx] < quanta[l] ? remaining[idx] : quanta[l];
+        time += slice;
+        // Nos níveis abaixo do 0, a próxima chegada interrompe a fatia
+        if (l > 0 && next < n && w->arrival[order[next]] < time) {
+            time = w->arrival[order[next]];
+        }
+        remaining[idx] -= time - start;
+        sim_printf("Tempo %d a %d executando processo %d (nível %d)\n", start, time, w->pid[idx], l);
+        log_run(0, w->pid[idx], start, time);
+
+        while (next < n && w->arrival[order[next]] <= time) {
+            int i = order[next++];
+            level[i] = 0;
+            queue[0][(front[0] + count[0]++) % n] = i;
+        }
+        if (remaining[idx] > 0) {
+            if (time - start == quanta[l] && l + 1 < levels) level[idx] = l + 1;
+            int dl = level[idx];
+            queue[dl][(front[dl] + count[dl]++) % n] = idx;
+        } else {
+            completed++;
+            complete_process(w, idx, time);
+        }
+
+        if (boost > 0 && time >= next_boost) {
+            // Boost: esvazia os níveis inferiores no nível 0, na ordem atual
+            for (int b = 1; b < levels; b++) {
+                while (count[b] > 0) {
+                    int i = queue[b][front[b]];
+                    front[b] = (front[b] + 1) % n;
+                    count[b]--;
+                    level[i] = 0;
+                    queue[0][(front[0] + count[0]++) % n] = i;
+                }
+            }
+            next_boost = (time / boost + 1) * boost;
+        }
+    }
+    log_end();
+    print_metrics(w);
+    for (int l = 0; l < levels; l++) free(queue[l]);
+    free(level);
+    free(order);
+}
+
+// Pesos por prioridade no estilo do CFS do Linux (nice 0 a 10): cada nível
+// a mais recebe cerca de 10% a menos de CPU
+static const int cfs_weights[] = { 1024, 820, 655, 526, 423, 335, 272, 215, 172, 137, 110 };
+
+static int cfs_weight(int priority) {
+    if (priority < 0) priority = 0;
+    if (priority > 10) priority = 10;
+    return cfs_weights[priority];
+}
+
+// Árvore de processos prontos do CFS: treap ordenada por (vruntime, índice),
+// com os nós guardados em vetores indexados pelo processo
+typedef struct {
+    int *left, *right;
+    unsigned *prio;
+    const long long *vruntime;
+    int root;
+} CfsTree;
+
+static int cfs_less(const CfsTree *t, int a, int b) {
+    return t->vruntime[a] < t->vruntime[b] || (t->vruntime[a] == t->vruntime[b] && a < b);
+}
+
+static int cfs_insert(CfsTree *t, int node, int i) {
+    if (node == -1) {
+        t->left[i] = t->right[i] = -1;
+        return i;
+    }
+    if (cfs_less(t, i, node)) {
+        t->left[node] = cfs_insert(t, t->left[node], i);
+        if (t->prio[t->left[node]] > t->prio[node]) { // rotação à direita
+            int l = t->left[node];
+            t->left[node] = t->right[l];
+            t->right[l] = node;
+            return l;
+        }
+    } else {
+        t->right[node] = cfs_insert(t, t->right[node], i);
+        if (t->prio[t->right[node]] > t->prio[node]) { // rotação à esquerda
+            int r = t->right[node];
+            t->right[node] = t->left[r];
+            t->left[r] = node;
+            return r;
+        }
+    }
+    return node;
+}
+
+// Remove e retorna o processo de menor vruntime (nó mais à esquerda)
+static int cfs_pop_min(CfsTree *t) {
+    int parent = -1, node = t->root;
+    while (t->left[node] != -1) {
+        parent = node;
+        node = t->left[node];
+    }
+    if (parent == -1) t->root = t->right[node];
+    else t->left[parent] = t->right[node];
+    return node;
+}
+
+// Escalonamento no estilo do CFS: roda sempre o processo de menor tempo
+// virtual (vruntime), que avança mais devagar para os de maior peso. A fatia
+// divide CFS_LATENCY entre os prontos na proporção dos pesos, com mínimo de
+// CFS_MIN_GRANULARITY. Quem chega começa no menor vruntime atual.
+void cfs(Workload *w) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    long long total_weight = 0, min_vruntime = 0;
+    int *remaining = w->remaining;
+    int *order = arrival_order(w);
+    long long *vruntime = (long long*) calloc(n, sizeof(long long));
+    CfsTree tree = { alloc_ints(n), alloc_ints(n), (unsigned*) malloc(n * sizeof(unsigned)), vruntime, -1 };
+    if (!vruntime || !tree.prio) {
+        printf("Erro ao alocar memória para a simulação.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned seed = 2463534242u;
+    for (int i = 0; i < n; i++) {
+        remaining[i] = w->burst[i];
+        w->response[i] = -1;
+        seed ^= seed << 13; // xorshift para as prioridades da treap
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        tree.prio[i] = seed;
+    }
+
+    summary_printf("\nExecutando Escalonamento CFS (latência = %d, granularidade mínima = %d):\n",
+           CFS_LATENCY, CFS_MIN_GRANULARITY);
+    log_begin(1, "CFS");
+
+    while (completed < n) {
+        if (tree.root == -1 && time < w->arrival[order[next]]) {
+            time = w->arrival[order[next]];
+        }
+        while (next < n && w->arrival[order[next]] <= time) {
+            int i = order[next++];
+            vruntime[i] = min_vruntime;
+            total_weight += cfs_weight(w->priority[i]);
+            tree.root = cfs_insert(&tree, tree.root, i);
+        }
+
+        int cur = cfs_pop_min(&tree);
+        int weight = cfs_weight(w->priority[cur]);
+        dispatch_process(w, cur, time);
+
+        long long slice = CFS_LATENCY * (long long) weight / total_weight;
+        if (slice < CFS_MIN_GRANULARITY) slice = CFS_MIN_GRANULARITY;
+        if (tree.root == -1 && next < n) {
+            // Sozinho na CPU: roda sem fatiar até a próxima chegada
+            long long until = w->arrival[order[next]] - time;
+            if (until > slice) slice = until;
+        } else if (tree.root == -1) {
+            slice = remaining[cur];
+        }
+        if (slice > remaining[cur]) slice = remaining[cur];
+        sim_printf("Tempo %d a %lld executando processo %d\n", time, time + slice, w->pid[cur]);
+        log_run(0, w->pid[cur], time, time + slice);
+        time += (int) slice;
+        remaining[cur] -= (int) slice;
+        // vruntime em 1/1024 de unidade de tempo, escalado pelo peso
+        vruntime[cur] += slice * 1024 * 1024 / weight;
+
+        // min_vruntime só avança: menor vruntime entre o atual e a árvore
+        long long candidate = vruntime[cur];
+        if (tree.root != -1) {
+            int m = tree.root;
+            while (tree.left[m] != -1) m = tree.left[m];
+            if (vruntime[m] < candidate) candidate = vruntime[m];
+        }
+        if (candidate > min_vruntime) min_vruntime = candidate;
+        if (remaining[cur] > 0) {
+            tree.root = cfs_insert(&tree, tree.root, cur);
+        } else {
+            completed++;
+            total_weight -= weight;
+            complete_process(w, cur, time);
+        }
+    }
+    log_end();
+    print_metrics(w);
+    free(order);
+    free(vruntime);
+    free(tree.left);
+    free(tree.right);
+    free(tree.prio);
+}
+
+// Fila de prontos de um núcleo: deque circular que cresce sob demanda. O
+// dono retira do início; um núcleo ocioso rouba do fim.
+typedef struct {
+    int *items;
+    int head, count, cap;
+} CpuQueue;
+
+static void cpu_queue_push(CpuQueue *q, int idx) {
+    if (q->count == q->cap) {
+        int cap = q->cap ? q->cap * 2 : 16;
+        int *items = alloc_ints(cap);
+        for (int i = 0; i < q->count; i++) items[i] = q->items[(q->head + i) % q->cap];
+        free(q->items);
+        q->items = items;
+        q->head = 0;
+        q->cap = cap;
+    }
+    q->items[(q->head + q->count++) % q->cap] = idx;
+}
+
+static int cpu_queue_pop_front(CpuQueue *q) {
+    int idx = q->items[q->head];
+    q->head = (q->head + 1) % q->cap;
+    q->count--;
+    return idx;
+}
+
+static int cpu_queue_pop_back(CpuQueue *q) {
+    return q->items[(q->head + --q->count) % q->cap];
+}
+
+// Estado da simulação SMP
+typedef struct {
+    Workload *w;
+    int cpus, quantum, migration_cost;
+    CpuQueue *queue;
+    int *current;       // processo em execução em cada núcleo (-1 = ocioso)
+    int *free_at;       // fim da fatia atual de cada núcleo
+    long long *busy;    // tempo ocupado (execução + migrações) por núcleo
+    int *remaining;
+    long migrations;
+    ReadyHeap running;  // núcleos ocupados, pelo fim da fatia
+} SmpState;
+
+// Coloca o próximo processo para rodar no núcleo c. Sem trabalho na própria
+// fila, o núcleo rouba do fim da fila mais longa (migração, que custa
+// migration_cost antes de o processo rodar); sem nada para roubar, fica ocioso.
+static void smp_dispatch(SmpState *s, int c, int time) {
+    Workload *w = s->w;
+    int cost = 0, idx;
+    if (s->queue[c].count > 0) {
+        idx = cpu_queue_pop_front(&s->queue[c]);
+    } else {
+        int victim = -1;
+        for (int v = 0; v < s->cpus; v++) {
+            if (s->queue[v].count > 0 && (victim == -1 || s->queue[v].count > s->queue[victim].count)) {
+                victim = v;
+            }
+        }
+        if (victim == -1) {
+            s->current[c] = -1;
+            return;
+        }
+        idx = cpu_queue_pop_back(&s->queue[victim]);
+        cost = s->migration_cost;
+        s->migrations++;
+        sim_printf("CPU %d: processo %d migrado da CPU %d\n", c, s->w->pid[idx], victim);
+        log_migrate(w->pid[idx], victim, c, time);
+    }
+    int slice = s->remaining[idx] < s->quantum ? s->remaining[idx] : s->quantum;
+    dispatch_process(w, idx, time + cost);
+    sim_printf("CPU %d: tempo %d a %d executando processo %d\n", c, time + cost, time + cost + slice, w->pid[idx]);
+    log_run(c, w->pid[idx], time + cost, time + cost + slice);
+    s->remaining[idx] -= slice;
+    s->current[c] = idx;
+    s->free_at[c] = time + cost + slice;
+    s->busy[c] += cost + slice;
+    heap_push(&s->running, c);
+}
+
+// Resultados do SMP além das métricas por processo
+typedef struct {
+    double utilization;  // média entre os núcleos, de 0 a 1
+    long migrations;
+} SmpStats;
+
+// Simulação com cpus núcleos, cada um com sua fila round robin (o processo
+// interrompido volta para a fila do mesmo núcleo). Balanceamento: cada
+// chegada vai para um núcleo ocioso ou, se não houver, para o de menor
+// carga; núcleos que ficam sem trabalho roubam das filas mais longas.
+// stats (opcional) recebe utilização e migrações.
+void smp_round_robin(Workload *w, int cpus, int quantum, int migration_cost,
+                     SmpStats *stats) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    int *order = arrival_order(w);
+    SmpState s;
+    s.w = w;
+    s.cpus = cpus;
+    s.quantum = quantum;
+    s.migration_cost = migration_cost;
+    s.queue = (CpuQueue*) calloc(cpus, sizeof(CpuQueue));
+    s.current = alloc_ints(cpus);
+    s.free_at = alloc_ints(cpus);
+    s.busy = (long long*) calloc(cpus, sizeof(long long));
+    s.remaining = w->remaining;
+    s.migrations = 0;
+    s.running.items = alloc_ints(cpus);
+    s.running.size = 0;
+    s.running.key = s.free_at;
+    if (!s.queue || !s.busy) {
+        printf("Erro ao alocar memória para a simulação.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < cpus; c++) s.current[c] = -1;
+    for (int i = 0; i < n; i++) {
+        s.remaining[i] = w->burst[i];
+        w->response[i] = -1;
+    }
+
+    summary_printf("\nExecutando Escalonamento SMP (%d CPUs, quantum = %d, custo de migração = %d):\n",
+           cpus, quantum, migration_cost);
+    log_begin(cpus, "SMP (%d CPUs, quantum = %d, custo de migração = %d)", cpus, quantum, migration_cost);
+
+    while (completed < n) {
+        // Chegadas são tratadas antes de fins de fatia no mesmo instante
+        if (next < n && (s.running.size == 0 ||
+                         w->arrival[order[next]] <= s.free_at[s.running.items[0]])) {
+            int i = order[next++];
+            if (time < w->arrival[i]) time = w->arrival[i];
+            int target = 0;
+            for (int c = 0; c < cpus; c++) {
+                int load = s.queue[c].count + (s.current[c] != -1);
+                int best = s.queue[target].count + (s.current[target] != -1);
+                if (load < best) target = c;
+            }
+            cpu_queue_push(&s.queue[target], i);
+            if (s.current[target] == -1) smp_dispatch(&s, target, time);
+            continue;
+        }
+
+        int c = heap_pop(&s.running);
+        int idx = s.current[c];
+        time = s.free_at[c];
+        if (s.remaining[idx] > 0) {
+            cpu_queue_push(&s.queue[c], idx);
+        } else {
+            completed++;
+            complete_process(w, idx, time);
+        }
+        smp_dispatch(&s, c, time);
+        // Núcleos ociosos roubam o que sobrou nas filas dos outros
+        for (int v = 0; v < cpus && s.running.size < cpus; v++) {
+            if (s.current[v] != -1) continue;
+            smp_dispatch(&s, v, time);
+            if (s.current[v] == -1) break; // nada para roubar
+        }
+    }
+
+    log_end();
+    print_metrics(w);
+    summary_printf("\nCPU\tOcupado\tUtilização\n");
+    for (int c = 0; c < cpus; c++) {
+        summary_printf("%d\t%lld\t%.1f%%\n", c, s.busy[c], time > 0 ? 100.0 * s.busy[c] / time : 0.0);
+    }
+    summary_printf("Makespan: %d\nMigrações: %ld\n", time, s.migrations);
+    if (stats) {
+        long long total = 0;
+        for (int c = 0; c < cpus; c++) total += s.busy[c];
+        stats->utilization = time > 0 ? (double) total / ((double) time * cpus) : 0.0;
+        stats->migrations = s.migrations;
+    }
+
+    for (int c = 0; c < cpus; c++) free(s.queue[c].items);
+    free(s.queue);
+    free(s.current);
+    free(s.free_at);
+    free(s.busy);
+    free(s.running.items);
+    free(order);
+}
+
+// Resultados da simulação com E/S, como frações do makespan
+typedef struct {
+    double cpu_utilization;
+    double io_utilization;
+    double overlap;       // CPU e dispositivo ocupados ao mesmo tempo
+    double throughput;    // processos concluídos por unidade de tempo
+} IoStats;
+
+// Round Robin com E/S: uma CPU e um dispositivo que atende um pedido por vez,
+// em ordem de chegada. Ao fim de uma rajada de CPU o processo fica WAITING na
+// fila do dispositivo; terminada a E/S, volta ao fim da fila de prontos com a
+// rajada seguinte. No mesmo instante, chegadas vêm antes de fins de E/S, que
+// vêm antes do fim da fatia. A espera conta só o tempo na fila de prontos.
+// stats (opcional) recebe utilizações, sobreposição e vazão.
+void io_round_robin(Workload *w, int quantum, IoStats *stats) {
+    int n = w->n;
+    int time = 0, completed = 0, next = 0;
+    int *order = arrival_order(w);
+    int *ready = alloc_ints(n), *device = alloc_ints(n); // filas circulares
+    int ready_front = 0, ready_count = 0, device_front = 0, device_count = 0;
+    int *phase = alloc_ints(n);        // rajada atual (índice em phases)
+    int *left = alloc_ints(n);         // restante da rajada de CPU atual
+    int *ready_since = alloc_ints(n);
+    int cur = -1, cpu_end = 0, slice = 0;
+    int io_cur = -1, io_end = 0;
+    long long cpu_busy = 0, io_busy = 0, overlap = 0;
+
+    for (int i = 0; i < n; i++) {
+        w->remaining[i] = w->burst[i];
+        w->response[i] = -1;
+        w->waiting[i] = 0;
+        phase[i] = 0;
+        left[i] = w->phase_count[i] > 0 ? w->phases[w->phase_first[i]] : w->burst[i];
+    }
+
+    summary_printf("\nExecutando Round Robin com E/S (quantum = %d):\n", quantum);
+    log_begin(1, "Round Robin com E/S (quantum = %d)", quantum);
+
+    while (completed < n) {
+        if (cur == -1 && ready_count > 0) {
+            cur = ready[ready_front];
+            ready_front = (ready_front + 1) % n;
+            ready_count--;
+            w->waiting[cur] += time - ready_since[cur];
+            w->state[cur] = RUNNING;
+            dispatch_process(w, cur, time);
+            slice = left[cur] < quantum ? left[cur] : quantum;
+            cpu_end = time + slice;
+            sim_printf("Tempo %d executando processo %d por %d unidades\n", time, w->pid[cur], slice);
+            log_run(0, w->pid[cur], time, cpu_end);
+        }
+        if (io_cur == -1 && device_count > 0) {
+            io_cur = device[device_front];
+            device_front = (device_front + 1) % n;
+            device_count--;
+            io_end = time + w->phases[w->phase_first[io_cur] + phase[io_cur]];
+            sim_printf("Tempo %d a %d E/S do processo %d\n", time, io_end, w->pid[io_cur]);
+        }
+
+        // Salta para o próximo evento, contando quem ficou ocupado até lá
+        int event = INT_MAX;
+        if (next < n) event = w->arrival[order[next]];
+        if (io_cur != -1 && io_end < event) event = io_end;
+        if (cur != -1 && cpu_end < event) event = cpu_end;
+        if (cur != -1) cpu_busy += event - time;
+        if (io_cur != -1) io_busy += event - time;
+        if (cur != -1 && io_cur != -1) overlap += event - time;
+        time = event;
+
+        if (next < n && w->arrival[order[next]] == time) {
+            while (next < n && w->arrival[order[next]] <= time) {
+                int i = order[next++];
+                ready[(ready_front + ready_count++) % n] = i;
+                ready_since[i] = time;
+                w->state[i] = READY;
+            }
+            continue;
+        }
+        if (io_cur != -1 && io_end == time) {
+            int i = io_cur;
+            io_cur = -1;
+            phase[i]++; // próxima rajada de CPU
+            left[i] = w->phases[w->phase_first[i] + phase[i]];
+            ready[(ready_front + ready_count++) % n] = i;
+            ready_since[i] = time;
+            w->state[i] = READY;
+            continue;
+        }
+
+        left[cur] -= slice;
+        w->remaining[cur] -= slice;
+        if (left[cur] > 0) {
+            ready[(ready_front + ready_count++) % n] = cur;
+            ready_since[cur] = time;
+            w->state[cur] = READY;
+        } else if (phase[cur] + 1 < w->phase_count[cur]) {
+            phase[cur]++; // rajada de E/S
+            device[(device_front + device_count++) % n] = cur;
+            w->state[cur] = WAITING;
+        } else {
+            int waited = w->waiting[cur];
+            completed++;
+            complete_process(w, cur, time);
+            w->waiting[cur] = waited; // sem descontar o tempo de E/S do turnaround
+        }
+        cur = -1;
+    }
+
+    log_end();
+    print_metrics(w);
+    double span = time > 0 ? time : 1;
+    summary_printf("\nUtilização da CPU: %.1f%%\nUtilização da E/S: %.1f%%\n", 100.0 * cpu_busy / span,
+                   100.0 * io_busy / span);
+    summary_printf("CPU e E/S ao mesmo tempo: %.1f%%\nVazão: %.4f processos por unidade de tempo\n",
+                   100.0 * overlap / span, n / span);
+    if (stats) {
+        stats->cpu_utilization = cpu_busy / span;
+        stats->io_utilization = io_busy / span;
+        stats->overlap = overlap / span;
+        stats->throughput = n / span;
+    }
+
+    free(order);
+    free(ready);
+    free(device);
+    free(phase);
+    free(left);
+    free(ready_since);
+}
+
+// Ordena o workload por chegada (o FCFS executa na ordem das colunas),
+// permutando as colunas de entrada
+void sort_by_arrival(Workload *w) {
+    int *order = arrival_order(w);
+    int *tmp = alloc_ints(w->n > 0 ? w->n : 1);
+    int *columns[] = { w->pid, w->arrival, w->burst, w->priority, w->phase_first, w->phase_count };
+    for (int c = 0; c < 6; c++) {
+        for (int i = 0; i < w->n; i++) tmp[i] = columns[c][order[i]];
+        memcpy(columns[c], tmp, w->n * sizeof(int));
+    }
+    free(tmp);
+    free(order);
+    reset_workload(w);
+}
+
+// Leitura de traces em blocos de TRACE_BUF_SIZE, byte a byte, sem carregar o
+// arquivo inteiro
+typedef struct {
+    FILE *file;
+    unsigned char buf[TRACE_BUF_SIZE];
+    size_t pos, len;
+} TraceReader;
+
+static int reader_byte(TraceReader *r) {
+    if (r->pos == r->len) {
+        r->len = fread(r->buf, 1, sizeof(r->buf), r->file);
+        r->pos = 0;
+        if (r->len == 0) return -1;
+    }
+    return r->buf[r->pos++];
+}
+
+static int reader_peek(TraceReader *r) {
+    int c = reader_byte(r);
+    if (c != -1) r->pos--;
+    return c;
+}
+
+// Lê um inteiro decimal (com sinal opcional) após espaços; retorna 0 se não houver
+static int read_csv_int(TraceReader *r, long long *out) {
+    int c = reader_peek(r);
+    while (c == ' ' || c == '\t') {
+        reader_byte(r);
+        c = reader_peek(r);
+    }
+    int neg = 0;
+    if (c == '-' || c == '+') {
+        neg = c == '-';
+        reader_byte(r);
+        c = reader_peek(r);
+    }
+    if (c < '0' || c > '9') return 0;
+    long long v = 0;
+    while (c >= '0' && c <= '9') {
+        if (v < 1000000000000LL) v = v * 10 + (c - '0');
+        reader_byte(r);
+        c = reader_peek(r);
+    }
+    *out = neg ? -v : v;
+    return 1;
+}
+
+static void skip_line(TraceReader *r) {
+    int c;
+    while ((c = reader_byte(r)) != -1 && c != '\n') {
+    }
+}
+
+// Trace CSV: uma linha "chegada,burst[,prioridade[,es,burst...]]" por
+// processo; os pares opcionais após a prioridade (até IO_MAX_BURSTS) são
+// rajadas de E/S, cada uma seguida da próxima rajada de CPU. Linhas vazias, comentários (#) e
+// cabeçalhos (linhas que não começam com número) são ignorados.
+static int load_csv_trace(TraceReader *r, Workload *w) {
+    long line = 0;
+    int c;
+    int seq[2 * IO_MAX_BURSTS + 1];
+    while ((c = reader_peek(r)) != -1) {
+        line++;
+        long long at, bt, pr = 0;
+        if (!read_csv_int(r, &at)) {
+            skip_line(r);
+            continue;
+        }
+        int ok = 1, seq_len = 0;
+        c = reader_byte(r);
+        if (c == ',' && read_csv_int(r, &bt)) {
+            c = reader_byte(r);
+            if (c == ',') {
+                ok = read_csv_int(r, &pr);
+                c = reader_byte(r);
+            }
+            // Rajadas (es, cpu) até o fim da linha
+            while (ok && c == ',') {
+                long long io, cpu;
+                ok = read_csv_int(r, &io) && reader_byte(r) == ',' && read_csv_int(r, &cpu) &&
+                     io > 0 && io <= INT_MAX && cpu > 0 && cpu <= INT_MAX &&
+                     seq_len < 2 * IO_MAX_BURSTS;
+                if (!ok) break;
+                if (seq_len == 0) seq[seq_len++] = (int) bt;
+                seq[seq_len++] = (int) io;
+                seq[seq_len++] = (int) cpu;
+                c = reader_byte(r);
+            }
+        } else {
+            ok = 0;
+        }
+        while (c == ' ' || c == '\t' || c == '\r') c = reader_byte(r);
+        if (!ok || (c != '\n' && c != -1) || at < 0 || at > INT_MAX || bt <= 0 || bt > INT_MAX ||
+            pr < INT_MIN || pr > INT_MAX) {
+            printf("Linha %ld do trace inválida.\n", line);
+            return 0;
+        }
+        add_process(w, w->n + 1, (int) bt, (int) at, (int) pr);
+        if (seq_len > 0) set_last_phases(w, seq, seq_len);
+    }
+    return 1;
+}
+
+// Inteiros sem sinal em base 128 (LEB128); os com sinal vão em zigzag
+static int read_varint(TraceReader *r, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = reader_byte(r);
+        if (c == -1) return 0;
+        v |= (uint64_t) (c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void write_varint(FILE *file, uint64_t v) {
+    unsigned char buf[10];
+    int n = 0;
+    do {
+        buf[n] = v & 0x7f;
+        v >>= 7;
+        if (v) buf[n] |= 0x80;
+        n++;
+    } while (v);
+    fwrite(buf, 1, n, file);
+}
+
+// Trace binário: TRACE_MAGIC e, por processo, três varints: diferença de
+// chegada para o anterior (zigzag), burst e prioridade (zigzag). Traces
+// ordenados por chegada ficam com 3 a 5 bytes por processo. Com
+// TRACE_MAGIC_IO, o burst é a primeira rajada de CPU e cada processo tem
+// ainda o número k de rajadas de E/S e k pares (es, cpu).
+static int load_binary_trace(TraceReader *r, Workload *w, int with_io) {
+    int64_t arrival = 0;
+    uint64_t delta, burst, priority, k;
+    int seq[2 * IO_MAX_BURSTS + 1];
+    while (reader_peek(r) != -1) {
+        if (!read_varint(r, &delta) || !read_varint(r, &burst) || !read_varint(r, &priority) ||
+            (with_io && !read_varint(r, &k))) {
+            printf("Trace binário truncado no processo %d.\n", w->n + 1);
+            return 0;
+        }
+        arrival += unzigzag(delta);
+        int64_t pr = unzigzag(priority);
+        int ok = arrival >= 0 && arrival <= INT_MAX && burst > 0 && burst <= INT_MAX &&
+                 pr >= INT_MIN && pr <= INT_MAX && (!with_io || k <= IO_MAX_BURSTS);
+        int len = 1;
+        seq[0] = (int) burst;
+        for (uint64_t j = 0; ok && with_io && j < 2 * k; j++) {
+            uint64_t v;
+            if (!read_varint(r, &v)) {
+                printf("Trace binário truncado no processo %d.\n", w->n + 1);
+                return 0;
+            }
+            ok = v > 0 && v <= INT_MAX;
+            seq[len++] = (int) v;
+        }
+        if (!ok) {
+            printf("Processo %d do trace binário inválido.\n", w->n + 1);
+            return 0;
+        }
+        add_process(w, w->n + 1, (int) burst, (int) arrival, (int) pr);
+        if (len > 1) set_last_phases(w, seq, len);
+    }
+    return 1;
+}
+
+// Carrega um trace (CSV ou binário, detectado pelo cabeçalho) para a lista
+int load_trace(const char *filename, Workload *w) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Não foi possível abrir o trace %s.\n", filename);
+        return 0;
+    }
+    TraceReader *r = (TraceReader*) malloc(sizeof(TraceReader));
+    if (!r) {
+        printf("Erro ao alocar memória para o trace.\n");
         exit(EXIT_FAILURE);
     }
-    proc->pid = pid;
-    proc->burst_time = burst_time;
-    proc->arrival_time = arrival_time;
-    proc->priority = priority;
-    proc->remaining_time = burst_time;
-    proc->state = NEW;
-    proc->start_time = -1;     // Ainda não executou
-    proc->completion_time = 0;
-    proc->waiting_time = 0;
-    proc->turnaround_time = 0;
-    proc->response_time = -1;  // Ainda não respondeu
-    return proc;
+    r->file = file;
+    r->pos = r->len = 0;
+
+    char magic[sizeof(TRACE_MAGIC) - 1];
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    int binary = got == sizeof(magic) && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+    int with_io = got == sizeof(magic) && memcmp(magic, TRACE_MAGIC_IO, sizeof(magic)) == 0;
+    int ok;
+    if (binary || with_io) {
+        ok = load_binary_trace(r, w, with_io);
+    } else {
+        // Não era binário: relê do início como CSV
+        rewind(file);
+        r->pos = r->len = 0;
+        ok = load_csv_trace(r, w);
+    }
+    free(r);
+    fclose(file);
+    if (ok && w->n == 0) {
+        printf("O trace %s não tem processos.\n", filename);
+        ok = 0;
+    }
+    return ok;
+}
+
+// Grava o workload no formato binário compacto (TRACE_MAGIC_IO só se algum
+// processo tiver E/S)
+int save_binary_trace(const char *filename, const Workload *w) {
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Não foi possível criar o trace %s.\n", filename);
+        return 0;
+    }
+    int with_io = w->n_phases > 0;
+    fwrite(with_io ? TRACE_MAGIC_IO : TRACE_MAGIC, 1, sizeof(TRACE_MAGIC) - 1, file);
+    int64_t prev = 0;
+    for (int i = 0; i < w->n; i++) {
+        int count = w->phase_count[i];
+        const int *seq = count > 0 ? w->phases + w->phase_first[i] : NULL;
+        write_varint(file, zigzag((int64_t) w->arrival[i] - prev));
+        write_varint(file, (uint64_t) (count > 0 ? seq[0] : w->burst[i]));
+        write_varint(file, zigzag(w->priority[i]));
+        if (with_io) {
+            write_varint(file, count > 0 ? (uint64_t) count / 2 : 0);
+            for (int k = 1; k < count; k++) write_varint(file, (uint64_t) seq[k]);
+        }
+        prev = w->arrival[i];
+    }
+    int ok = fflush(file) == 0 && !ferror(file);
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) printf("Erro ao gravar o trace %s.\n", filename);
+    return ok;
 }
 
-void free_process(Process *p) {
-    free(p);
+// Gerador de números aleatórios (xorshift64*) do gerador de workloads
+static uint64_t rng_next(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
 }
 
-// Imprime as métricas após a simulação para análise e comparação
-void print_metrics(Process **processes, int n) {
-    float total_wait = 0, total_turnaround = 0, total_response = 0;
-    printf("\nPID\tBurst\tArrival\tWait\tTurnaround\tResponse\n");
-    for (int i = 0; i < n; i++) {
-        printf("%d\t%d\t%d\t%d\t%d\t\t%d\n",
-            processes[i]->pid, processes[i]->burst_time, processes[i]->arrival_time,
-            processes[i]->waiting_time, processes[i]->turnaround_time, processes[i]->response_time);
-        total_wait += processes[i]->waiting_time;
-        total_turnaround += processes[i]->turnaround_time;
-        total_response += (processes[i]->response_time == -1) ? 0 : processes[i]->response_time;
+// Uniforme em (0, 1)
+static double rng_uniform(uint64_t *state) {
+    return ((rng_next(state) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+typedef enum { BURST_PARETO, BURST_LOGNORMAL } BurstDist;
+
+typedef struct {
+    int count;
+    double rate;        // chegadas por unidade de tempo (Poisson)
+    double mean_burst;
+    BurstDist dist;
+    double shape;       // alfa da Pareto ou sigma da lognormal
+    int max_priority;
+    uint64_t seed;
+    int io_bursts;      // rajadas de E/S por processo (0 = só CPU)
+    double io_mean;     // duração média da E/S (exponencial)
+} WorkloadSpec;
+
+// Gera um workload sintético: chegadas de Poisson (intervalos exponenciais)
+// e bursts de cauda pesada com a média pedida. Pareto(alfa) tem escala
+// média * (alfa - 1) / alfa; lognormal(sigma) tem mu = ln(média) - sigma²/2.
+// Com io_bursts > 0, o burst de cada processo é dividido em io_bursts + 1
+// rajadas de CPU (menos, se for curto demais) intercaladas com E/S.
+void generate_workload(const WorkloadSpec *spec, Workload *w) {
+    int seq[2 * IO_MAX_BURSTS + 1];
+    workload_reserve(w, w->n + spec->count); // tamanho conhecido: sem realocações
+    uint64_t state = spec->seed ? spec->seed : 88172645463325252ULL;
+    double arrival = 0;
+    double scale = spec->mean_burst * (spec->shape - 1) / spec->shape;
+    double mu = log(spec->mean_burst) - spec->shape * spec->shape / 2;
+    for (int i = 0; i < spec->count; i++) {
+        double burst;
+        if (spec->dist == BURST_PARETO) {
+            burst = scale / pow(rng_uniform(&state), 1.0 / spec->shape);
+        } else {
+            // Box-Muller para a normal padrão
+            double z = sqrt(-2 * log(rng_uniform(&state))) * cos(2 * M_PI * rng_uniform(&state));
+            burst = exp(mu + spec->shape * z);
+        }
+        if (burst < 1) burst = 1;
+        if (burst > GEN_MAX_BURST) burst = GEN_MAX_BURST;
+        int priority = (int) (rng_next(&state) % (uint64_t) (spec->max_priority + 1));
+        if (arrival > INT_MAX) {
+            printf("Chegadas ultrapassaram o limite de tempo; workload truncado em %d processos.\n", i);
+            break;
+        }
+        add_process(w, i + 1, (int) (burst + 0.5), (int) arrival, priority);
+        int cpu = w->burst[w->n - 1];
+        int k = spec->io_bursts < cpu - 1 ? spec->io_bursts : cpu - 1;
+        if (k > 0) {
+            for (int j = 0; j <= k; j++) {
+                seq[2 * j] = cpu / (k + 1) + (j < cpu % (k + 1));
+                if (j < k) seq[2 * j + 1] = 1 + (int) (-log(rng_uniform(&state)) * (spec->io_mean - 1));
+            }
+            set_last_phases(w, seq, 2 * k + 1);
+        }
+        arrival += -log(rng_uniform(&state)) / spec->rate;
     }
-    printf("\nMédias:\nEspera: %.2f\nTurnaround: %.2f\nResposta: %.2f\n",
-           total_wait / n, total_turnaround / n, total_response / n);
 }
 
-// Escalonamento FCFS (First-Come, First-Served)
-void fcfs(Process **processes, int n) {
-    int time = 0;
-    printf("\nExecutando Escalonamento FCFS:\n");
-    for (int i = 0; i < n; i++) {
-        Process *p = processes[i];
-        if (time < p->arrival_time) time = p->arrival_time; // Espera o processo chegar
-        p->start_time = time;
-        p->waiting_time = time - p->arrival_time;
-        p->response_time = p->waiting_time;
-        p->completion_time = time + p->burst_time;
-        p->turnaround_time = p->completion_time - p->arrival_time;
-        printf("Processo %d executando de %d a %d\n", p->pid, p->start_time, p->completion_time);
-        time += p->burst_time;
-    }
-    print_metrics(processes, n);
-}
-
-// Escalonamento SJF preemptivo (Shortest Remaining Time First)
-void sjf_preemptive(Process **processes, int n) {
-    int time = 0, completed = 0;
-    int min_remain;
-    int shortest = -1;
-    int *first_response = (int*)malloc(n * sizeof(int));
-    int *remaining = (int*)malloc(n * sizeof(int));
+// Algoritmos disponíveis no modo sweep
+typedef enum {
+    ALG_FCFS, ALG_SJF, ALG_RR, ALG_PRIO, ALG_PPRIO, ALG_MLFQ, ALG_CFS, ALG_SMP, ALG_IO, ALG_COUNT
+} Algorithm;
 
-    for (int i = 0; i < n; i++) {
-        remaining[i] = processes[i]->burst_time;
-        first_response[i] = -1;
+static const char *algorithm_names[ALG_COUNT] = {
+    "fcfs", "sjf", "rr", "prio", "pprio", "mlfq", "cfs", "smp", "rrio"
+};
+
+// Uma configuração da grade e seus resultados
+typedef struct {
+    Algorithm alg;
+    int quantum, cpus;
+    Summary summary;
+    double utilization;      // CPU (média entre os núcleos no smp)
+    double io_utilization;   // dispositivo de E/S (só rrio)
+    double throughput;       // processos por unidade de tempo
+    long migrations;
+    double wall_ms;
+} SweepCell;
+
+typedef struct {
+    const Workload *w;     // workload original (só leitura durante o sweep)
+    int migration_cost;
+    SweepCell *cells;
+    int n_cells;
+    int next_cell;         // próxima célula a simular (compartilhado entre as threads)
+} SweepJob;
+
+// Roda um algoritmo com os parâmetros fixos dos modos não interativos
+static void run_algorithm(Workload *w, Algorithm alg, int quantum, int cpus, int migration_cost,
+                          SmpStats *smp, IoStats *io) {
+    int quanta[SWEEP_MLFQ_LEVELS];
+    switch (alg) {
+        case ALG_FCFS:  fcfs(w); break;
+        case ALG_SJF:   sjf_preemptive(w); break;
+        case ALG_RR:    round_robin(w, quantum); break;
+        case ALG_PRIO:  priority_scheduling(w, 0, SWEEP_AGING); break;
+        case ALG_PPRIO: priority_scheduling(w, 1, SWEEP_AGING); break;
+        case ALG_MLFQ:
+            // Quantum dobra a cada nível, sem boost
+            for (int l = 0; l < SWEEP_MLFQ_LEVELS; l++) quanta[l] = quantum << l;
+            mlfq(w, SWEEP_MLFQ_LEVELS, quanta, 0);
+            break;
+        case ALG_CFS:   cfs(w); break;
+        case ALG_SMP:   smp_round_robin(w, cpus, quantum, migration_cost, smp); break;
+        case ALG_IO:    io_round_robin(w, quantum, io); break;
+        default: break;
     }
+}
 
-    printf("\nExecutando Escalonamento SJF Preemptivo:\n");
+// Simula uma célula sobre uma cópia própria dos processos
+static void run_sweep_cell(SweepJob *job, SweepCell *cell) {
+    Workload copy = {0};
+    copy_workload(&copy, job->w);
+    reset_workload(&copy);
+    long long total_burst = 0;
+    for (int i = 0; i < copy.n; i++) total_burst += copy.burst[i];
 
-    while (completed < n) {
-        min_remain = 1e9;
-        shortest = -1;
-        // Escolhe processo com menor tempo restante e que já chegou
-        for (int i = 0; i < n; i++) {
-            if (processes[i]->arrival_time <= time && remaining[i] > 0 && remaining[i] < min_remain) {
-                min_remain = remaining[i];
-                shortest = i;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    SmpStats smp = { 0, 0 };
+    IoStats io = { 0, 0, 0, 0 };
+    run_algorithm(&copy, cell->alg, cell->quantum, cell->cpus, job->migration_cost, &smp, &io);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    summarize(&copy, &cell->summary);
+    if (cell->alg == ALG_SMP) {
+        cell->utilization = smp.utilization;
+        cell->migrations = smp.migrations;
+    } else {
+        cell->utilization = cell->summary.makespan > 0 ? (double) total_burst / cell->summary.makespan : 0.0;
+        cell->migrations = 0;
+    }
+    cell->io_utilization = io.io_utilization;
+    cell->throughput = cell->summary.makespan > 0 ? (double) copy.n / cell->summary.makespan : 0.0;
+    cell->wall_ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    free_workload(&copy);
+}
+
+// Thread do pool: pega a próxima célula até acabar
+static void* sweep_worker(void *arg) {
+    SweepJob *job = (SweepJob*) arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&job->next_cell, 1, __ATOMIC_RELAXED);
+        if (i >= job->n_cells) break;
+        run_sweep_cell(job, &job->cells[i]);
+    }
+    return NULL;
+}
+
+// Lê uma lista de inteiros positivos separados por vírgula
+static int parse_int_list(const char *text, int *out, int max, int *n) {
+    *n = 0;
+    while (*text) {
+        char *end;
+        long v = strtol(text, &end, 10);
+        if (end == text || v <= 0 || v > INT_MAX || *n == max) return 0;
+        out[(*n)++] = (int) v;
+        text = end;
+        if (*text == ',') text++;
+        else if (*text) return 0;
+    }
+    return *n > 0;
+}
+
+// Lê a lista de algoritmos ("all" = todos)
+static int parse_algorithms(const char *text, int *selected) {
+    int any = 0;
+    for (int a = 0; a < ALG_COUNT; a++) selected[a] = 0;
+    while (*text) {
+        size_t len = strcspn(text, ",");
+        int found = 0;
+        for (int a = 0; a < ALG_COUNT; a++) {
+            if ((strlen(algorithm_names[a]) == len && strncmp(text, algorithm_names[a], len) == 0) ||
+                (len == 3 && strncmp(text, "all", 3) == 0)) {
+                selected[a] = 1;
+                found = any = 1;
             }
         }
-        if (shortest == -1) {
-            time++;
-            continue;
+        if (!found) {
+            printf("Algoritmo desconhecido: %.*s (use %s", (int) len, text, algorithm_names[0]);
+            for (int a = 1; a < ALG_COUNT; a++) printf(", %s", algorithm_names[a]);
+            printf(" ou all).\n");
+            return 0;
+        }
+        text += len;
+        if (*text == ',') text++;
+    }
+    return any;
+}
+
+// Colunas de uma métrica: média e percentis
+static void write_metric_csv(FILE *out, const MetricStats *m) {
+    fprintf(out, "%.4f,%.4f,%.4f,%.4f,", m->mean, m->p50, m->p95, m->p99);
+}
+
+static void write_metric_json(FILE *out, const char *name, const MetricStats *m) {
+    fprintf(out, "\"%s_mean\": %.4f, \"%s_p50\": %.4f, \"%s_p95\": %.4f, \"%s_p99\": %.4f, ",
+            name, m->mean, name, m->p50, name, m->p95, name, m->p99);
+}
+
+static void write_sweep_results(FILE *out, const SweepCell *cells, int n_cells, int json) {
+    if (json) fprintf(out, "[\n");
+    else fprintf(out, "algorithm,quantum,cpus,"
+                      "wait_mean,wait_p50,wait_p95,wait_p99,"
+                      "turnaround_mean,turnaround_p50,turnaround_p95,turnaround_p99,"
+                      "response_mean,response_p50,response_p95,response_p99,"
+                      "makespan,utilization,io_utilization,throughput,migrations,wall_ms\n");
+    for (int i = 0; i < n_cells; i++) {
+        const SweepCell *c = &cells[i];
+        if (json) {
+            fprintf(out, "  {\"algorithm\": \"%s\", \"quantum\": %d, \"cpus\": %d, ",
+                    algorithm_names[c->alg], c->quantum, c->cpus);
+            write_metric_json(out, "wait", &c->summary.wait);
+            write_metric_json(out, "turnaround", &c->summary.turnaround);
+            write_metric_json(out, "response", &c->summary.response);
+            fprintf(out, "\"makespan\": %d, \"utilization\": %.4f, \"io_utilization\": %.4f, "
+                         "\"throughput\": %.6f, \"migrations\": %ld, \"wall_ms\": %.3f}%s\n",
+                    c->summary.makespan, c->utilization, c->io_utilization, c->throughput,
+                    c->migrations, c->wall_ms, i + 1 < n_cells ? "," : "");
+        } else {
+            fprintf(out, "%s,%d,%d,", algorithm_names[c->alg], c->quantum, c->cpus);
+            write_metric_csv(out, &c->summary.wait);
+            write_metric_csv(out, &c->summary.turnaround);
+            write_metric_csv(out, &c->summary.response);
+            fprintf(out, "%d,%.4f,%.4f,%.6f,%ld,%.3f\n", c->summary.makespan, c->utilization,
+                    c->io_utilization, c->throughput, c->migrations, c->wall_ms);
         }
+    }
+    if (json) fprintf(out, "]\n");
+}
 
-        if (first_response[shortest] == -1) {
-            first_response[shortest] = time - processes[shortest]->arrival_time;
-            processes[shortest]->start_time = time;
+// Modo sweep: simula a grade algoritmos x quanta x CPUs sobre o mesmo
+// workload em um pool de threads e grava uma tabela CSV ou JSON. Quantum só
+// varia para rr, mlfq, smp e rrio; CPUs só para smp.
+int run_sweep(const Workload *w, const char *algorithms, const char *quanta_list,
+              const char *cpus_list, int migration_cost, int jobs, int json, const char *out_file) {
+    int selected[ALG_COUNT], quanta[SWEEP_MAX_VALUES], cpus[SWEEP_MAX_VALUES];
+    int n_quanta, n_cpus;
+    if (!parse_algorithms(algorithms, selected)) return 0;
+    if (!parse_int_list(quanta_list, quanta, SWEEP_MAX_VALUES, &n_quanta) ||
+        !parse_int_list(cpus_list, cpus, SWEEP_MAX_VALUES, &n_cpus)) {
+        printf("Listas de quanta e CPUs devem ter de 1 a %d inteiros positivos.\n", SWEEP_MAX_VALUES);
+        return 0;
+    }
+
+    SweepJob job = { w, migration_cost, NULL, 0, 0 };
+    job.cells = (SweepCell*) calloc((size_t) ALG_COUNT * n_quanta * n_cpus, sizeof(SweepCell));
+    if (!job.cells) {
+        printf("Erro ao alocar memória para o sweep.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int a = 0; a < ALG_COUNT; a++) {
+        if (!selected[a]) continue;
+        int uses_quantum = a == ALG_RR || a == ALG_MLFQ || a == ALG_SMP || a == ALG_IO;
+        for (int q = 0; q < (uses_quantum ? n_quanta : 1); q++) {
+            for (int c = 0; c < (a == ALG_SMP ? n_cpus : 1); c++) {
+                SweepCell *cell = &job.cells[job.n_cells++];
+                cell->alg = (Algorithm) a;
+                cell->quantum = uses_quantum ? quanta[q] : 0;
+                cell->cpus = a == ALG_SMP ? cpus[c] : 1;
+            }
         }
+    }
 
-        printf("Tempo %d executando processo %d\n", time, processes[shortest]->pid);
-        remaining[shortest]--;
-        time++;
+    FILE *out = stdout;
+    if (out_file && !(out = fopen(out_file, "w"))) {
+        printf("Não foi possível criar %s.\n", out_file);
+        free(job.cells);
+        return 0;
+    }
 
-        if (remaining[shortest] == 0) {
-            completed++;
-            int finish_time = time;
-            processes[shortest]->completion_time = finish_time;
-            processes[shortest]->turnaround_time = finish_time - processes[shortest]->arrival_time;
-            processes[shortest]->waiting_time = processes[shortest]->turnaround_time - processes[shortest]->burst_time;
-            processes[shortest]->response_time = first_response[shortest];
-            printf("Processo %d finalizado em %d\n", processes[shortest]->pid, finish_time);
+    if (jobs < 1) jobs = 1;
+    if (jobs > job.n_cells) jobs = job.n_cells;
+    int was_quiet = quiet;
+    quiet = 2; // antes das threads: as simulações não imprimem nada
+    pthread_t *threads = (pthread_t*) malloc(jobs * sizeof(pthread_t));
+    if (!threads) {
+        printf("Erro ao alocar memória para o sweep.\n");
+        exit(EXIT_FAILURE);
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int t = 0; t < jobs; t++) {
+        if (pthread_create(&threads[t], NULL, sweep_worker, &job) != 0) {
+            printf("Erro ao criar thread do sweep.\n");
+            exit(EXIT_FAILURE);
         }
     }
-    print_metrics(processes, n);
-    free(first_response);
-    free(remaining);
+    for (int t = 0; t < jobs; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    quiet = was_quiet;
+
+    write_sweep_results(out, job.cells, job.n_cells, json);
+    int ok = 1;
+    if (out != stdout) {
+        ok = fclose(out) == 0;
+        if (!ok) printf("Erro ao gravar %s.\n", out_file);
+    }
+    fprintf(stderr, "%d configurações em %.1f ms com %d threads.\n", job.n_cells,
+            (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6, jobs);
+    free(threads);
+    free(job.cells);
+    return ok;
 }
 
-// Escalonamento Round Robin com quantum configurável e preempção
-void round_robin(Process **processes, int n, int quantum) {
-    int time = 0, completed = 0;
-    int *remaining = (int*) malloc(n * sizeof(int));
-    int *response_time = (int*) malloc(n * sizeof(int));
-    int *started = (int*) calloc(n, sizeof(int));
-    int *queue = (int*) malloc(n * n * sizeof(int)); // fila circular 
-    int front=0, rear=0;
+// Resultado de um algoritmo em um tamanho do --bench
+typedef struct {
+    Algorithm alg;
+    int n, repeats;
+    long long events;   // por execução
+    double wall_ms;     // execução mais rápida
+    long peak_rss_kb;
+    Summary summary;
+    uint64_t checksum;
+} BenchResult;
 
-    for (int i=0; i<n; i++) {
-        remaining[i] = processes[i]->burst_time;
-        response_time[i] = -1;
+// Impressão digital do escalonamento (FNV-1a sobre início, término e espera
+// de cada processo): muda se qualquer resultado por processo mudar
+static uint64_t workload_checksum(const Workload *w) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < w->n; i++) {
+        int32_t v[3] = { w->start[i], w->completion[i], w->waiting[i] };
+        const unsigned char *p = (const unsigned char*) v;
+        for (size_t b = 0; b < sizeof(v); b++) {
+            h ^= p[b];
+            h *= 1099511628211ULL;
+        }
     }
+    return h;
+}
 
-    // Enfileira processos que já chegaram
-    for (int i=0; i<n; i++) {
-        if (processes[i]->arrival_time <= time) {
-            queue[rear++] = i;
-            started[i] = 1;
-            response_time[i] = 0;
-            processes[i]->start_time = time;
+static void write_bench_results(FILE *out, const BenchResult *r, int count) {
+    fprintf(out, "[\n");
+    for (int i = 0; i < count; i++) {
+        double seconds = r[i].wall_ms / 1e3;
+        fprintf(out, "  {\"algorithm\": \"%s\", \"n\": %d, \"quantum\": %d, \"cpus\": %d, \"events\": %lld, "
+                     "\"repeats\": %d, \"wall_ms\": %.3f, \"events_per_s\": %.0f, \"peak_rss_kb\": %ld, ",
+                algorithm_names[r[i].alg], r[i].n, BENCH_QUANTUM, r[i].alg == ALG_SMP ? BENCH_CPUS : 1,
+                r[i].events, r[i].repeats, r[i].wall_ms, seconds > 0 ? r[i].events / seconds : 0.0,
+                r[i].peak_rss_kb);
+        write_metric_json(out, "wait", &r[i].summary.wait);
+        write_metric_json(out, "turnaround", &r[i].summary.turnaround);
+        write_metric_json(out, "response", &r[i].summary.response);
+        fprintf(out, "\"makespan\": %d, \"checksum\": \"%016llx\"}%s\n", r[i].summary.makespan,
+                (unsigned long long) r[i].checksum, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+// Valor de "chave": em uma linha gravada por write_bench_results
+static const char* json_field(const char *line, const char *key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *p = strstr(line, pattern);
+    return p ? p + strlen(pattern) : NULL;
+}
+
+// Compara com um resultado anterior do --bench. Makespan e checksum precisam
+// ser idênticos; vazão (eventos/s) mais de tolerance% abaixo da anterior é
+// regressão de desempenho. Entradas sem par no baseline são só avisadas.
+// O relatório vai para report.
+static int compare_bench_baseline(const char *filename, const BenchResult *r, int count, double tolerance,
+                                  FILE *report) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        fprintf(report, "Não foi possível abrir o baseline %s.\n", filename);
+        return 0;
+    }
+    int ok = 1;
+    int *matched = (int*) calloc(count, sizeof(int));
+    if (!matched) {
+        printf("Erro ao alocar memória para o benchmark.\n");
+        exit(EXIT_FAILURE);
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), file)) {
+        const char *alg = json_field(line, "algorithm"), *n = json_field(line, "n");
+        const char *rate = json_field(line, "events_per_s"), *makespan = json_field(line, "makespan");
+        const char *checksum = json_field(line, "checksum");
+        if (!alg || !n || !rate || !makespan || !checksum) continue;
+        for (int i = 0; i < count; i++) {
+            const char *name = algorithm_names[r[i].alg];
+            size_t len = strlen(name);
+            if (matched[i] || alg[0] != '"' || strncmp(alg + 1, name, len) != 0 || alg[len + 1] != '"' ||
+                atoi(n) != r[i].n) {
+                continue;
+            }
+            matched[i] = 1;
+            char expected[17];
+            snprintf(expected, sizeof(expected), "%016llx", (unsigned long long) r[i].checksum);
+            double seconds = r[i].wall_ms / 1e3, now = seconds > 0 ? r[i].events / seconds : 0.0;
+            double before = atof(rate);
+            if (atoi(makespan) != r[i].summary.makespan || strncmp(checksum + 1, expected, 16) != 0) {
+                fprintf(report, "DIFERENTE  %-6s n=%d: resultados mudaram em relação ao baseline\n", name, r[i].n);
+                ok = 0;
+            } else if (before > 0 && now < before * (1 - tolerance / 100)) {
+                fprintf(report, "REGRESSÃO  %-6s n=%d: %.0f eventos/s, antes %.0f (%.1f%% mais lento)\n",
+                       name, r[i].n, now, before, 100 * (1 - now / before));
+                ok = 0;
+            } else {
+                fprintf(report, "OK         %-6s n=%d: %.0f eventos/s, antes %.0f\n", name, r[i].n, now, before);
+            }
+            break;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (!matched[i]) {
+            fprintf(report, "SEM PAR    %-6s n=%d: não está no baseline\n", algorithm_names[r[i].alg], r[i].n);
         }
     }
+    free(matched);
+    fclose(file);
+    return ok;
+}
 
-    printf("\nExecutando Escalonamento Round Robin (quantum = %d):\n", quantum);
+// Modo benchmark: roda os algoritmos escolhidos em workloads gerados com
+// semente fixa (Pareto 1.5 com média 10, utilização de 90%, duas rajadas de
+// E/S por processo para o rrio) nos tamanhos pedidos e grava em JSON eventos
+// simulados por segundo, pico de memória (RSS do processo até ali), métricas
+// e o checksum dos resultados. Execuções curtas se repetem até somar
+// BENCH_MIN_MS e vale a mais rápida, para que a vazão não seja só ruído.
+// Com baseline, falha se algum resultado mudar ou se a vazão cair mais que
+// tolerance%.
+int run_bench(const char *algorithms, const char *sizes_list, const char *out_file,
+              const char *baseline, double tolerance) {
+    int selected[ALG_COUNT], sizes[SWEEP_MAX_VALUES], n_sizes;
+    if (!parse_algorithms(algorithms, selected)) return 0;
+    if (!parse_int_list(sizes_list, sizes, SWEEP_MAX_VALUES, &n_sizes)) {
+        printf("Tamanhos do benchmark devem ser de 1 a %d inteiros positivos.\n", SWEEP_MAX_VALUES);
+        return 0;
+    }
+    BenchResult *results = (BenchResult*) calloc((size_t) n_sizes * ALG_COUNT, sizeof(BenchResult));
+    if (!results) {
+        printf("Erro ao alocar memória para o benchmark.\n");
+        exit(EXIT_FAILURE);
+    }
+    int count = 0, was_quiet = quiet;
+    quiet = 2;
+    for (int s = 0; s < n_sizes; s++) {
+        WorkloadSpec spec = { sizes[s], BENCH_RATE, 10.0, BURST_PARETO, 1.5, 10, BENCH_SEED, 2, 4.0 };
+        Workload w = {0};
+        generate_workload(&spec, &w);
+        sort_by_arrival(&w);
+        for (int a = 0; a < ALG_COUNT; a++) {
+            if (!selected[a]) continue;
+            BenchResult *r = &results[count++];
+            SmpStats smp;
+            IoStats io;
+            struct rusage usage;
+            double total_ms = 0;
+            r->repeats = 0;
+            r->wall_ms = 0;
+            do {
+                struct timespec t0, t1;
+                reset_workload(&w);
+                sim_events = 0;
+                clock_gettime(CLOCK_MONOTONIC, &t0);
+                run_algorithm(&w, (Algorithm) a, BENCH_QUANTUM, BENCH_CPUS, 0, &smp, &io);
+                clock_gettime(CLOCK_MONOTONIC, &t1);
+                double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+                if (r->repeats == 0 || ms < r->wall_ms) r->wall_ms = ms;
+                total_ms += ms;
+                r->repeats++;
+            } while (total_ms < BENCH_MIN_MS);
+            getrusage(RUSAGE_SELF, &usage);
+            r->alg = (Algorithm) a;
+            r->n = w.n;
+            r->events = sim_events;
+            r->peak_rss_kb = usage.ru_maxrss;
+            summarize(&w, &r->summary);
+            r->checksum = workload_checksum(&w);
+            fprintf(stderr, "n=%d %-6s %10.1f ms %8.2f M eventos/s\n", r->n, algorithm_names[a], r->wall_ms,
+                    r->wall_ms > 0 ? r->events / r->wall_ms / 1e3 : 0.0);
+        }
+        free_workload(&w);
+    }
+    quiet = was_quiet;
 
-    while (completed < n) {
-        if (front == rear) { // fila vazia, avança tempo
-            time++;
-            for (int i=0; i<n; i++) {
-                if (!started[i] && processes[i]->arrival_time <= time) {
-                    queue[rear++] = i;
-                    started[i] = 1;
-                    response_time[i] = time - processes[i]->arrival_time;
-                    processes[i]->start_time = time;
-                }
+    int ok = 1;
+    FILE *out = stdout;
+    if (out_file && !(out = fopen(out_file, "w"))) {
+        printf("Não foi possível criar %s.\n", out_file);
+        ok = 0;
+    } else {
+        write_bench_results(out, results, count);
+        if (out != stdout && fclose(out) != 0) {
+            printf("Erro ao gravar %s.\n", out_file);
+            ok = 0;
+        }
+    }
+    // Com o JSON em stdout, o relatório do baseline vai para stderr
+    if (ok && baseline) {
+        ok = compare_bench_baseline(baseline, results, count, tolerance, out_file ? stdout : stderr);
+    }
+    free(results);
+    return ok;
+}
+
+// Modo de execução real (--real): cada processo vira uma fibra (ucontext)
+// que faz trabalho de CPU calibrado, burst * unidade de tempo. Um pool de
+// workers (threads) escolhe as fibras pela política; uma thread de timer
+// marca o fim do quantum e a fibra cede a CPU no próximo ponto de checagem.
+// Os tempos medidos são comparados com os da simulação do mesmo workload.
+typedef enum { REAL_FCFS, REAL_SJF, REAL_RR, REAL_PRIO } RealPolicy;
+
+static const char *real_policy_names[] = { "fcfs", "sjf", "rr", "prio" };
+
+typedef struct {
+    ucontext_t ctx;
+    void *stack;           // alocada no primeiro despacho, liberada no fim
+    long long work_left;   // iterações de trabalho restantes
+    int worker;            // worker em que a fibra está rodando
+    int done;
+} Fiber;
+
+typedef struct {
+    ucontext_t ctx;        // laço de escalonamento do worker
+    long long deadline;    // fim do quantum em ns (LLONG_MAX = sem preempção)
+    int preempt;           // sinalizado pela thread de timer
+} RealWorker;
+
+typedef struct {
+    Workload *w;
+    RealPolicy policy;
+    int quantum, workers, unit_us;
+    long long iters_per_unit;
+    Fiber *fibers;
+    RealWorker *cpu;
+    pthread_mutex_t lock;  // protege fila, cursor de chegadas e contadores
+    pthread_cond_t changed;
+    ReadyHeap ready;
+    int *key;
+    int seq;               // ordem de entrada na fila (FIFO de fcfs e rr)
+    int *order, next;
+    int completed, finished;
+    long long t0;
+    long long *first_run, *cpu_time, *completion; // ns desde t0
+    long dispatches;
+} RealRun;
+
+// makecontext só passa int para a fibra; só há uma execução real por vez
+static RealRun *real_run = NULL;
+
+static long long now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// Trabalho de CPU sem memória: gerador congruencial em um volátil
+static void spin(long long iters) {
+    volatile unsigned x = 1;
+    for (long long k = 0; k < iters; k++) x = x * 1664525u + 1013904223u;
+}
+
+// Iterações de spin que levam unit_us microssegundos nesta máquina
+static long long calibrate_spin(int unit_us) {
+    long long iters = 0, batch = 100000, start = now_ns(), elapsed;
+    do {
+        spin(batch);
+        iters += batch;
+        elapsed = now_ns() - start;
+    } while (elapsed < REAL_CALIBRATION_MS * 1000000LL);
+    long long per_unit = (long long) ((double) iters * unit_us * 1000 / elapsed);
+    return per_unit > 0 ? per_unit : 1;
+}
+
+static void fiber_main(int i) {
+    RealRun *r = real_run;
+    Fiber *f = &r->fibers[i];
+    long long chunk = r->iters_per_unit / REAL_CHECKS_PER_UNIT;
+    if (chunk < 1) chunk = 1;
+    while (f->work_left > 0) {
+        long long step = f->work_left < chunk ? f->work_left : chunk;
+        spin(step);
+        f->work_left -= step;
+        // Depois de retomada, a fibra pode estar em outro worker
+        RealWorker *cpu = &r->cpu[f->worker];
+        if (f->work_left > 0 && __atomic_load_n(&cpu->preempt, __ATOMIC_ACQUIRE)) {
+            swapcontext(&f->ctx, &cpu->ctx);
+        }
+    }
+    f->done = 1;
+    setcontext(&r->cpu[f->worker].ctx); // uc_link não serve: o worker final varia
+}
+
+// Chave da fila de prontos para a política (menor roda antes)
+static void real_enqueue(RealRun *r, int i) {
+    switch (r->policy) {
+        case REAL_SJF:
+            r->key[i] = (int) ((r->fibers[i].work_left + r->iters_per_unit - 1) / r->iters_per_unit);
+            break;
+        case REAL_PRIO:
+            r->key[i] = r->w->priority[i] * SWEEP_AGING + r->w->arrival[i];
+            break;
+        default:
+            r->key[i] = r->seq++;
+            break;
+    }
+    heap_push(&r->ready, i);
+}
+
+static void* real_worker(void *arg) {
+    RealRun *r = real_run;
+    int c = (int) (intptr_t) arg, n = r->w->n;
+    RealWorker *cpu = &r->cpu[c];
+    long long slice_ns = r->policy == REAL_RR || r->policy == REAL_SJF ?
+                         (long long) r->quantum * r->unit_us * 1000 : LLONG_MAX;
+    pthread_mutex_lock(&r->lock);
+    while (r->completed < n) {
+        long long now = now_ns() - r->t0;
+        while (r->next < n && (long long) r->w->arrival[r->order[r->next]] * r->unit_us * 1000 <= now) {
+            real_enqueue(r, r->order[r->next++]);
+        }
+        if (r->ready.size == 0) {
+            if (r->next < n) {
+                // Dorme até a próxima chegada (ou até alguém devolver uma fibra)
+                long long at = r->t0 + (long long) r->w->arrival[r->order[r->next]] * r->unit_us * 1000;
+                struct timespec ts = { at / 1000000000LL, at % 1000000000LL };
+                pthread_cond_timedwait(&r->changed, &r->lock, &ts);
+            } else {
+                pthread_cond_wait(&r->changed, &r->lock);
             }
             continue;
         }
 
-        int idx = queue[front++];
-        int exec_time = (remaining[idx] > quantum) ? quantum : remaining[idx];
-        printf("Tempo %d executando processo %d por %d unidades\n", time, processes[idx]->pid, exec_time);
-        remaining[idx] -= exec_time;
-        time += exec_time;
-
-        // Enfileira processos que chegaram durante execução
-        for (int i=0; i<n; i++) {
-            if (!started[i] && processes[i]->arrival_time <= time) {
-                queue[rear++] = i;
-                started[i] = 1;
-                response_time[i] = time - processes[i]->arrival_time;
-                processes[i]->start_time = time;
+        int i = heap_pop(&r->ready);
+        Fiber *f = &r->fibers[i];
+        f->worker = c;
+        if (r->first_run[i] < 0) r->first_run[i] = now;
+        if (!f->stack) {
+            f->stack = malloc(REAL_STACK_SIZE);
+            if (!f->stack) {
+                printf("Erro ao alocar memória para a fibra.\n");
+                exit(EXIT_FAILURE);
             }
+            getcontext(&f->ctx);
+            f->ctx.uc_stack.ss_sp = f->stack;
+            f->ctx.uc_stack.ss_size = REAL_STACK_SIZE;
+            f->ctx.uc_link = NULL;
+            makecontext(&f->ctx, (void (*)(void)) fiber_main, 1, i);
         }
+        r->dispatches++;
+        pthread_mutex_unlock(&r->lock);
 
-        if (remaining[idx] > 0) {
-            queue[rear++] = idx; // Reinsere caso não tenha terminado
+        long long start = now_ns();
+        __atomic_store_n(&cpu->preempt, 0, __ATOMIC_RELEASE);
+        __atomic_store_n(&cpu->deadline, slice_ns == LLONG_MAX ? LLONG_MAX : start + slice_ns, __ATOMIC_RELEASE);
+        swapcontext(&cpu->ctx, &f->ctx);
+        long long end = now_ns();
+        __atomic_store_n(&cpu->deadline, LLONG_MAX, __ATOMIC_RELEASE);
+
+        pthread_mutex_lock(&r->lock);
+        r->cpu_time[i] += end - start;
+        if (f->done) {
+            r->completion[i] = end - r->t0;
+            r->completed++;
+            free(f->stack);
+            f->stack = NULL;
+            if (r->completed == n) pthread_cond_broadcast(&r->changed);
+        } else {
+            real_enqueue(r, i);
+            pthread_cond_signal(&r->changed);
         }
-        else {
-            completed++;
-            processes[idx]->completion_time = time;
-            processes[idx]->turnaround_time = time - processes[idx]->arrival_time;
-            processes[idx]->waiting_time = processes[idx]->turnaround_time - processes[idx]->burst_time;
-            processes[idx]->response_time = response_time[idx];
-            printf("Processo %d finalizado em %d\n", processes[idx]->pid, time);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+// Thread de timer: a cada quarto de quantum, pede preempção aos workers cuja
+// fatia terminou
+static void* real_timer(void *arg) {
+    RealRun *r = (RealRun*) arg;
+    long long tick = (long long) r->quantum * r->unit_us * 1000 / 4;
+    if (tick < 50000) tick = 50000;
+    struct timespec ts = { tick / 1000000000LL, tick % 1000000000LL };
+    while (!__atomic_load_n(&r->finished, __ATOMIC_ACQUIRE)) {
+        nanosleep(&ts, NULL);
+        long long now = now_ns();
+        for (int c = 0; c < r->workers; c++) {
+            if (now >= __atomic_load_n(&r->cpu[c].deadline, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&r->cpu[c].preempt, 1, __ATOMIC_RELEASE);
+            }
         }
     }
-    print_metrics(processes, n);
-    free(remaining);
-    free(response_time);
-    free(started);
-    free(queue);
+    return NULL;
+}
+
+// Métrica simulada e medida lado a lado, em unidades de tempo
+static void print_real_row(const char *name, const MetricStats *sim, const MetricStats *real, double scale) {
+    if (sim) {
+        printf("%-12s%10.2f%10.2f%10.2f%10.2f\n", name, sim->mean, sim->p95,
+               real->mean * scale, real->p95 * scale);
+    } else {
+        printf("%-12s%10s%10s%10.2f%10.2f\n", name, "-", "-", real->mean * scale, real->p95 * scale);
+    }
+}
+
+// Executa o workload de verdade com a política e compara com a simulação.
+// Na simulação, sjf é o SRTF (o real só reavalia a cada quantum), prio usa o
+// aging do sweep e rr com vários workers é o SMP sem custo de migração; fcfs,
+// sjf e prio com mais de um worker não têm modelo simulado. No rr simulado,
+// a resposta conta até a entrada na fila; a medida, até o primeiro despacho.
+int run_real(const Workload *src, const char *policy_name, int workers, int quantum, int unit_us) {
+    int policy = -1;
+    for (int p = 0; p < 4; p++) {
+        if (strcmp(policy_name, real_policy_names[p]) == 0) policy = p;
+    }
+    if (policy == -1) {
+        printf("Política desconhecida: %s (use fcfs, sjf, rr ou prio).\n", policy_name);
+        return 0;
+    }
+    if (src->n > REAL_MAX_PROCESSES || workers < 1 || quantum < 1 || unit_us < 1) {
+        printf("Execução real: até %d processos, workers, quantum e unidade positivos.\n", REAL_MAX_PROCESSES);
+        return 0;
+    }
+    int n = src->n;
+    long long total = 0;
+    for (int i = 0; i < n; i++) total += src->burst[i];
+    printf("Calibrando... ");
+    fflush(stdout);
+    RealRun r;
+    memset(&r, 0, sizeof(r));
+    r.iters_per_unit = calibrate_spin(unit_us);
+    printf("%lld iterações por unidade de %d us. CPU total: %.2f s em %d workers.\n",
+           r.iters_per_unit, unit_us, total * unit_us / 1e6, workers);
+
+    Workload measured = {0};
+    copy_workload(&measured, src);
+    reset_workload(&measured);
+    r.w = &measured;
+    r.policy = (RealPolicy) policy;
+    r.quantum = quantum;
+    r.workers = workers;
+    r.unit_us = unit_us;
+    r.fibers = (Fiber*) calloc(n, sizeof(Fiber));
+    r.cpu = (RealWorker*) calloc(workers, sizeof(RealWorker));
+    r.first_run = (long long*) malloc(n * sizeof(long long));
+    r.cpu_time = (long long*) calloc(n, sizeof(long long));
+    r.completion = (long long*) calloc(n, sizeof(long long));
+    pthread_t *threads = (pthread_t*) malloc(workers * sizeof(pthread_t));
+    if (!r.fibers || !r.cpu || !r.first_run || !r.cpu_time || !r.completion || !threads) {
+        printf("Erro ao alocar memória para a execução real.\n");
+        exit(EXIT_FAILURE);
+    }
+    r.key = alloc_ints(n);
+    r.ready.items = alloc_ints(n);
+    r.ready.key = r.key;
+    r.order = arrival_order(&measured);
+    for (int i = 0; i < n; i++) {
+        r.fibers[i].work_left = measured.burst[i] * r.iters_per_unit;
+        r.first_run[i] = -1;
+    }
+    for (int c = 0; c < workers; c++) r.cpu[c].deadline = LLONG_MAX;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&r.changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&r.lock, NULL);
+    real_run = &r;
+
+    pthread_t timer;
+    r.t0 = now_ns();
+    if (pthread_create(&timer, NULL, real_timer, &r) != 0) {
+        printf("Erro ao criar thread de timer.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < workers; c++) {
+        if (pthread_create(&threads[c], NULL, real_worker, (void*) (intptr_t) c) != 0) {
+            printf("Erro ao criar worker.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int c = 0; c < workers; c++) pthread_join(threads[c], NULL);
+    double elapsed_ms = (now_ns() - r.t0) / 1e6;
+    __atomic_store_n(&r.finished, 1, __ATOMIC_RELEASE);
+    pthread_join(timer, NULL);
+    real_run = NULL;
+
+    // Resultados medidos em microssegundos, nas colunas do workload
+    for (int i = 0; i < n; i++) {
+        long long arrival_us = (long long) measured.arrival[i] * unit_us;
+        measured.start[i] = (int) (r.first_run[i] / 1000);
+        measured.completion[i] = (int) (r.completion[i] / 1000);
+        measured.turnaround[i] = (int) (r.completion[i] / 1000 - arrival_us);
+        measured.response[i] = (int) (r.first_run[i] / 1000 - arrival_us);
+        measured.waiting[i] = (int) ((r.completion[i] - r.cpu_time[i]) / 1000 - arrival_us);
+        measured.state[i] = TERMINATED;
+    }
+    Summary real_sum, sim_sum;
+    summarize(&measured, &real_sum);
+
+    // Mesma política na simulação
+    Algorithm alg = ALG_COUNT;
+    if (workers == 1) {
+        const Algorithm single[] = { ALG_FCFS, ALG_SJF, ALG_RR, ALG_PRIO };
+        alg = single[policy];
+    } else if (policy == REAL_RR) {
+        alg = ALG_SMP;
+    }
+    int has_model = alg != ALG_COUNT;
+    if (has_model) {
+        Workload sim = {0};
+        copy_workload(&sim, src);
+        reset_workload(&sim);
+        SmpStats smp;
+        IoStats io;
+        int was_quiet = quiet;
+        quiet = 2;
+        run_algorithm(&sim, alg, quantum, workers, 0, &smp, &io);
+        quiet = was_quiet;
+        summarize(&sim, &sim_sum);
+        free_workload(&sim);
+    }
+
+    double scale = 1.0 / unit_us; // microssegundos -> unidades de tempo
+    printf("\nExecução real (%s, %d workers, quantum = %d, unidade = %d us): %.1f ms, %ld despachos\n",
+           policy_name, workers, quantum, unit_us, elapsed_ms, r.dispatches);
+    printf("%-12s%20s%20s\n", "", "Simulado", "Medido");
+    printf("%-12s%10s%10s%10s%10s\n", "", "média", "p95", "média", "p95");
+    print_real_row("Espera", has_model ? &sim_sum.wait : NULL, &real_sum.wait, scale);
+    print_real_row("Turnaround", has_model ? &sim_sum.turnaround : NULL, &real_sum.turnaround, scale);
+    print_real_row("Resposta", has_model ? &sim_sum.response : NULL, &real_sum.response, scale);
+    if (has_model) {
+        printf("Makespan: simulado %d, medido %.2f unidades\n", sim_sum.makespan, real_sum.makespan * scale);
+    } else {
+        printf("Sem modelo simulado para %s com %d workers.\n", policy_name, workers);
+    }
+
+    pthread_mutex_destroy(&r.lock);
+    pthread_cond_destroy(&r.changed);
+    free(r.fibers);
+    free(r.cpu);
+    free(r.first_run);
+    free(r.cpu_time);
+    free(r.completion);
+    free(r.key);
+    free(r.ready.items);
+    free(r.order);
+    free(threads);
+    free_workload(&measured);
+    return 1;
 }
 
 // Função para limpar buffer stdin
@@ -212,13 +2462,13 @@ void flush_input() {
 }
 
 // Função para obter processos do usuário
-int input_processes(Process **processes, int max_processes) {
+int input_processes(Workload *w) {
     int n;
-    printf("Digite o número de processos (máximo %d): ", max_processes);
+    printf("Digite o número de processos: ");
     scanf("%d", &n);
     flush_input();
 
-    if (n <= 0 || n > max_processes) {
+    if (n <= 0) {
         printf("Número inválido de processos.\n");
         return 0;
     }
@@ -236,17 +2486,153 @@ int input_processes(Process **processes, int max_processes) {
         scanf("%d", &pr);
         flush_input();
 
-        processes[i] = create_process(i+1, bt, at, pr);
+        add_process(w, i+1, bt, at, pr);
     }
     return n;
 }
 
 // Menu principal para o usuário escolher algoritmo e execução
-int main() {
-    const int MAX_PROCESS = 100;
-    Process *processes[MAX_PROCESS];
-    int n_process = 0;
-    int quantum;
+// Opções de linha de comando:
+//   --trace <arquivo>            carrega um trace CSV ou binário
+//   --generate <n>               gera n processos (--rate, --mean-burst,
+//                                --dist pareto|lognormal, --shape, --seed,
+//                                --io-bursts e --io-mean para rajadas de E/S)
+//   --export-trace <arquivo>     grava o workload em binário e sai
+//   --sweep <algoritmos>         simula a grade algoritmos x --quanta x --cpus
+//                                (listas com vírgula) em -j threads e grava
+//                                CSV ou JSON (--format, --out); ver run_sweep
+//   --bench <algoritmos>         benchmark em workloads fixos (--bench-sizes,
+//                                --baseline, --tolerance, --out); ver run_bench
+//   --real <fcfs|sjf|rr|prio>    executa o workload em fibras reais (--workers,
+//                                --quantum, --time-unit em us); ver run_real
+//   --log <arquivo>              grava as simulações do menu no log binário de
+//                                eventos (ver EventLog e visualizadorgantt.c)
+//   --quiet                      não imprime a linha do tempo, só as métricas
+// Com um workload carregado, o menu simula sempre esse workload.
+int main(int argc, char *argv[]) {
+    Workload work = {0};
+    int quantum, aging, levels, boost, cpus, migration_cost;
+    int quanta[MLFQ_MAX_LEVELS];
+    const char *export_file = NULL, *log_file = NULL;
+    WorkloadSpec spec = { 0, 1.0, 10.0, BURST_PARETO, 0, 10, 0, 0, 10.0 };
+    const char *sweep = NULL, *sweep_quanta = "4", *sweep_cpus = "4", *sweep_out = NULL;
+    int sweep_jobs = (int) sysconf(_SC_NPROCESSORS_ONLN), sweep_json = 0, sweep_migration = 0;
+    const char *bench = NULL, *bench_sizes = "1000,10000,100000,1000000", *baseline = NULL;
+    double tolerance = 25;
+    const char *real = NULL;
+    int real_workers = 1, real_quantum = 4, real_unit = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            if (!load_trace(argv[++i], &work)) {
+                free_workload(&work);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            spec.count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            spec.rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--mean-burst") == 0 && i + 1 < argc) {
+            spec.mean_burst = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--dist") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "pareto") == 0) spec.dist = BURST_PARETO;
+            else if (strcmp(argv[i], "lognormal") == 0) spec.dist = BURST_LOGNORMAL;
+            else {
+                printf("Distribuição desconhecida: %s (use pareto ou lognormal).\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--shape") == 0 && i + 1 < argc) {
+            spec.shape = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            spec.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--io-bursts") == 0 && i + 1 < argc) {
+            spec.io_bursts = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--io-mean") == 0 && i + 1 < argc) {
+            spec.io_mean = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--export-trace") == 0 && i + 1 < argc) {
+            export_file = argv[++i];
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweep = argv[++i];
+        } else if (strcmp(argv[i], "--quanta") == 0 && i + 1 < argc) {
+            sweep_quanta = argv[++i];
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            sweep_cpus = argv[++i];
+        } else if (strcmp(argv[i], "--migration-cost") == 0 && i + 1 < argc) {
+            sweep_migration = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            sweep_jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            sweep_json = strcmp(argv[++i], "json") == 0;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            sweep_out = argv[++i];
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench = argv[++i];
+        } else if (strcmp(argv[i], "--bench-sizes") == 0 && i + 1 < argc) {
+            bench_sizes = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--real") == 0 && i + 1 < argc) {
+            real = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            real_workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quantum") == 0 && i + 1 < argc) {
+            real_quantum = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--time-unit") == 0 && i + 1 < argc) {
+            real_unit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            log_file = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = 1;
+        } else {
+            printf("Opção inválida: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (bench) {
+        free_workload(&work);
+        return run_bench(bench, bench_sizes, sweep_out, baseline, tolerance) ? 0 : 1;
+    }
+    if (spec.count > 0) {
+        if (spec.shape <= 0) spec.shape = spec.dist == BURST_PARETO ? 1.5 : 1.0;
+        if (spec.rate <= 0 || spec.mean_burst < 1 || (spec.dist == BURST_PARETO && spec.shape <= 1) ||
+            spec.io_bursts < 0 || spec.io_bursts > IO_MAX_BURSTS || spec.io_mean < 1) {
+            printf("Parâmetros do gerador inválidos (rate > 0, mean-burst >= 1, shape > 1 na Pareto, "
+                   "io-bursts de 0 a %d, io-mean >= 1).\n", IO_MAX_BURSTS);
+            return 1;
+        }
+        generate_workload(&spec, &work);
+    }
+    int preloaded = work.n > 0;
+    if (preloaded) {
+        sort_by_arrival(&work);
+        if (!sweep) printf("Workload com %d processos carregado.\n", work.n); // não mistura com a tabela
+    }
+    if (sweep) {
+        int ok = preloaded && run_sweep(&work, sweep, sweep_quanta, sweep_cpus,
+                               sweep_migration < 0 ? 0 : sweep_migration, sweep_jobs,
+                               sweep_json, sweep_out);
+        if (!preloaded) printf("O sweep precisa de um workload (--trace ou --generate).\n");
+        free_workload(&work);
+        return ok ? 0 : 1;
+    }
+    if (real) {
+        int ok = preloaded && run_real(&work, real, real_workers, real_quantum, real_unit);
+        if (!preloaded) printf("A execução real precisa de um workload (--trace ou --generate).\n");
+        free_workload(&work);
+        return ok ? 0 : 1;
+    }
+    if (export_file) {
+        int ok = preloaded && save_binary_trace(export_file, &work);
+        free_workload(&work);
+        return ok ? 0 : 1;
+    }
+    if (log_file && !open_event_log(log_file)) {
+        free_workload(&work);
+        return 1;
+    }
 
     while (1) {
         printf("\n--- Simulador de Escalonamento de Processos ---\n");
@@ -254,6 +2640,12 @@ int main() {
         printf("2. Shortest Job First (Preemptivo)\n");
         printf("3. Round Robin\n");
         printf("4. Sair\n");
+        printf("5. Prioridade (Não Preemptivo)\n");
+        printf("6. Prioridade (Preemptivo)\n");
+        printf("7. Multi-Level Feedback Queue (MLFQ)\n");
+        printf("8. Completely Fair Scheduler (CFS)\n");
+        printf("9. Multiprocessador (SMP, Round Robin por CPU)\n");
+        printf("10. Round Robin com E/S (CPU e dispositivo)\n");
         printf("Escolha uma opção: ");
         int option;
         scanf("%d", &option);
@@ -264,15 +2656,18 @@ int main() {
             break;
         }
 
-        n_process = input_processes(processes, MAX_PROCESS);
-        if (n_process == 0) continue;
+        if (preloaded) {
+            reset_workload(&work);
+        } else if (input_processes(&work) == 0) {
+            continue;
+        }
 
         switch(option) {
             case 1:
-                fcfs(processes, n_process);
+                fcfs(&work);
                 break;
             case 2:
-                sjf_preemptive(processes, n_process);
+                sjf_preemptive(&work);
                 break;
             case 3:
                 printf("Digite o valor do quantum: ");
@@ -282,17 +2677,86 @@ int main() {
                     quantum = 2;
                     printf("Quantum inválido. Usando valor padrão 2.\n");
                 }
-                round_robin(processes, n_process, quantum);
+                round_robin(&work, quantum);
+                break;
+            case 5:
+            case 6:
+                printf("Intervalo de aging (espera que vale um nível de prioridade): ");
+                scanf("%d", &aging);
+                flush_input();
+                if (aging <= 0) {
+                    aging = 10;
+                    printf("Intervalo inválido. Usando valor padrão 10.\n");
+                }
+                priority_scheduling(&work, option == 6, aging);
+                break;
+            case 7:
+                printf("Número de níveis (1 a %d): ", MLFQ_MAX_LEVELS);
+                scanf("%d", &levels);
+                flush_input();
+                if (levels < 1 || levels > MLFQ_MAX_LEVELS) {
+                    levels = 3;
+                    printf("Número inválido. Usando valor padrão 3.\n");
+                }
+                for (int l = 0; l < levels; l++) {
+                    printf("Quantum do nível %d: ", l);
+                    scanf("%d", &quanta[l]);
+                    flush_input();
+                    if (quanta[l] <= 0) {
+                        quanta[l] = 2 << l;
+                        printf("Quantum inválido. Usando valor padrão %d.\n", quanta[l]);
+                    }
+                }
+                printf("Intervalo de boost (0 = sem boost): ");
+                scanf("%d", &boost);
+                flush_input();
+                if (boost < 0) boost = 0;
+                mlfq(&work, levels, quanta, boost);
+                break;
+            case 8:
+                cfs(&work);
+                break;
+            case 9:
+                printf("Número de CPUs: ");
+                scanf("%d", &cpus);
+                flush_input();
+                if (cpus <= 0) {
+                    cpus = 4;
+                    printf("Número inválido. Usando valor padrão 4.\n");
+                }
+                printf("Digite o valor do quantum: ");
+                scanf("%d", &quantum);
+                flush_input();
+                if (quantum <= 0) {
+                    quantum = 2;
+                    printf("Quantum inválido. Usando valor padrão 2.\n");
+                }
+                printf("Custo de migração entre CPUs: ");
+                scanf("%d", &migration_cost);
+                flush_input();
+                if (migration_cost < 0) migration_cost = 0;
+                smp_round_robin(&work, cpus, quantum, migration_cost, NULL);
+                break;
+            case 10:
+                printf("Digite o valor do quantum: ");
+                scanf("%d", &quantum);
+                flush_input();
+                if (quantum <= 0) {
+                    quantum = 2;
+                    printf("Quantum inválido. Usando valor padrão 2.\n");
+                }
+                io_round_robin(&work, quantum, NULL);
                 break;
             default:
                 printf("Opção inválida.\n");
                 break;
         }
 
-        // Libera memória para os processos criados
-        for (int i = 0; i < n_process; i++) {
-            free_process(processes[i]);
+        // Libera memória para os processos digitados
+        if (!preloaded) {
+            work.n = 0;
         }
     }
-    return 0;
+    free_workload(&work);
+    return close_event_log() ? 0 : 1;
 }
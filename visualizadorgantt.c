@@ -0,0 +1,264 @@
+// Compilar com: gcc visualizadorgantt.c -o visualizadorgantt
+// Lê o log binário de eventos gravado por simuladorescalonamentodeprocessos
+// --log e mostra, para cada simulação, um resumo e um gráfico de Gantt em
+// texto. Uso: visualizadorgantt <log> [--width colunas] [--summary]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define EVENT_MAGIC "SCHE1"      // Cabeçalho do log (igual ao do simulador)
+#define DEFAULT_WIDTH 100        // Colunas do gráfico de Gantt
+#define MAX_NAME 128             // Nome da simulação no registro 'B'
+
+// Símbolo de cada processo no gráfico: pid módulo 62
+static const char labels[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+// Um registro do log, com os tempos já absolutos
+typedef struct {
+    int type;
+    int cpu, pid, from, to;
+    int64_t start, end;
+} Event;
+
+// Resumo de uma simulação
+typedef struct {
+    char name[MAX_NAME];
+    int cpus;
+    int64_t makespan;
+    long runs, finished, migrations, switches;
+    int64_t *busy;      // tempo ocupado por CPU
+    long *cpu_switches; // trocas de contexto por CPU
+    int *last_pid;      // último processo visto em cada CPU (-1 = nenhum)
+} RunStats;
+
+// Gráfico: para cada CPU e coluna, o processo que mais ocupou aquele trecho
+typedef struct {
+    int pid;
+    int64_t amount;
+} Cell;
+
+static int read_varint(FILE *file, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(file);
+        if (c == EOF) return 0;
+        v |= (uint64_t) (c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int64_t unzigzag(uint64_t v) { return (int64_t) (v >> 1) ^ -(int64_t) (v & 1); }
+
+static int read_time(FILE *file, int64_t *last, int64_t *out) {
+    uint64_t delta;
+    if (!read_varint(file, &delta)) return 0;
+    *out = *last + unzigzag(delta);
+    *last = *out;
+    return 1;
+}
+
+// Lê o próximo registro dentro de uma simulação. Retorna 0 se truncado ou
+// inválido. Os tempos são relativos ao fim do registro anterior (*last).
+static int read_event(FILE *file, int64_t *last, int cpus, Event *e) {
+    uint64_t a, b, c, len;
+    e->type = getc(file);
+    switch (e->type) {
+        case 'R':
+            if (!read_varint(file, &a) || !read_varint(file, &b) ||
+                !read_time(file, last, &e->start) || !read_varint(file, &len) || a >= (uint64_t) cpus) {
+                return 0;
+            }
+            e->cpu = (int) a;
+            e->pid = (int) b;
+            e->end = e->start + (int64_t) len;
+            *last = e->end;
+            return 1;
+        case 'F':
+            if (!read_varint(file, &a) || !read_time(file, last, &e->end)) return 0;
+            e->pid = (int) a;
+            return 1;
+        case 'M':
+            if (!read_varint(file, &a) || !read_varint(file, &b) || !read_varint(file, &c) ||
+                !read_time(file, last, &e->end)) {
+                return 0;
+            }
+            e->pid = (int) a;
+            e->from = (int) b;
+            e->to = (int) c;
+            return 1;
+        case 'E':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Lê o registro 'B' (o byte de tipo já foi consumido)
+static int read_begin(FILE *file, RunStats *s) {
+    uint64_t cpus, len;
+    if (!read_varint(file, &cpus) || !read_varint(file, &len) || cpus == 0 || cpus > 65536 ||
+        len >= MAX_NAME || fread(s->name, 1, len, file) != len) {
+        return 0;
+    }
+    s->name[len] = '\0';
+    s->cpus = (int) cpus;
+    return 1;
+}
+
+static void* alloc_or_die(size_t size) {
+    void *p = calloc(1, size);
+    if (!p) {
+        printf("Erro ao alocar memória.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// Primeira passada: contadores, tempo ocupado e trocas de contexto
+static int scan_run(FILE *file, RunStats *s) {
+    s->busy = (int64_t*) alloc_or_die(s->cpus * sizeof(int64_t));
+    s->cpu_switches = (long*) alloc_or_die(s->cpus * sizeof(long));
+    s->last_pid = (int*) alloc_or_die(s->cpus * sizeof(int));
+    for (int c = 0; c < s->cpus; c++) s->last_pid[c] = -1;
+    int64_t last = 0;
+    Event e;
+    for (;;) {
+        if (!read_event(file, &last, s->cpus, &e)) return 0;
+        if (e.type == 'E') return 1;
+        if (e.end > s->makespan) s->makespan = e.end;
+        if (e.type == 'R') {
+            s->runs++;
+            s->busy[e.cpu] += e.end - e.start;
+            // Fatias contíguas do mesmo processo já vêm unidas no log
+            if (s->last_pid[e.cpu] != -1 && s->last_pid[e.cpu] != e.pid) {
+                s->cpu_switches[e.cpu]++;
+                s->switches++;
+            }
+            s->last_pid[e.cpu] = e.pid;
+        } else if (e.type == 'F') {
+            s->finished++;
+        } else {
+            s->migrations++;
+        }
+    }
+}
+
+// Segunda passada: distribui cada fatia pelas colunas que ela cobre
+static int fill_gantt(FILE *file, const RunStats *s, Cell *cells, int width) {
+    int64_t last = 0;
+    Event e;
+    for (;;) {
+        if (!read_event(file, &last, s->cpus, &e)) return 0;
+        if (e.type == 'E') return 1;
+        if (e.type != 'R') continue;
+        Cell *row = cells + (size_t) e.cpu * width;
+        int first = (int) (e.start * width / s->makespan);
+        int end_col = (int) ((e.end - 1) * width / s->makespan);
+        for (int col = first; col <= end_col && col < width; col++) {
+            // Trecho [col_start, col_end) da coluna coberto pela fatia
+            int64_t col_start = (col * s->makespan + width - 1) / width;
+            int64_t col_end = ((col + 1) * s->makespan + width - 1) / width;
+            int64_t from = e.start > col_start ? e.start : col_start;
+            int64_t to = e.end < col_end ? e.end : col_end;
+            if (to - from > row[col].amount) {
+                row[col].amount = to - from;
+                row[col].pid = e.pid;
+            }
+        }
+    }
+}
+
+static void print_summary(const RunStats *s, int index) {
+    printf("\n=== Simulação %d: %s ===\n", index, s->name);
+    printf("Makespan: %lld  Fatias: %ld  Trocas de contexto: %ld  Finalizados: %ld  Migrações: %ld\n",
+           (long long) s->makespan, s->runs, s->switches, s->finished, s->migrations);
+    for (int c = 0; c < s->cpus; c++) {
+        printf("CPU %d: ocupada %lld (%.1f%%), %ld trocas de contexto\n", c, (long long) s->busy[c],
+               s->makespan > 0 ? 100.0 * s->busy[c] / s->makespan : 0.0, s->cpu_switches[c]);
+    }
+}
+
+static void print_gantt(const RunStats *s, const Cell *cells, int width) {
+    printf("\nGantt (%.2f unidades de tempo por coluna; símbolo = pid módulo 62, '.' = ociosa)\n",
+           (double) s->makespan / width);
+    for (int c = 0; c < s->cpus; c++) {
+        printf("CPU %-3d|", c);
+        for (int col = 0; col < width; col++) {
+            const Cell *cell = &cells[(size_t) c * width + col];
+            putchar(cell->amount > 0 ? labels[cell->pid % 62] : '.');
+        }
+        printf("|\n");
+    }
+    printf("        0%*lld\n", width - 1, (long long) s->makespan);
+}
+
+int main(int argc, char *argv[]) {
+    const char *filename = NULL;
+    int width = DEFAULT_WIDTH, summary_only = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            summary_only = 1;
+        } else if (!filename && argv[i][0] != '-') {
+            filename = argv[i];
+        } else {
+            printf("Opção inválida: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!filename || width < 10) {
+        printf("Uso: %s <log> [--width colunas (>= 10)] [--summary]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Não foi possível abrir o log %s.\n", filename);
+        return 1;
+    }
+    char magic[sizeof(EVENT_MAGIC) - 1];
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, EVENT_MAGIC, sizeof(magic)) != 0) {
+        printf("%s não é um log de eventos do simulador.\n", filename);
+        fclose(file);
+        return 1;
+    }
+
+    int index = 0, ok = 1;
+    int type;
+    while ((type = getc(file)) != EOF) {
+        RunStats s;
+        memset(&s, 0, sizeof(s));
+        long offset = 0;
+        ok = type == 'B' && read_begin(file, &s) && (offset = ftell(file)) >= 0 && scan_run(file, &s);
+        if (ok) {
+            print_summary(&s, ++index);
+            if (!summary_only && s.makespan > 0) {
+                // Relê a simulação: o gráfico precisa do makespan para a escala
+                int cols = s.makespan < width ? (int) s.makespan : width;
+                Cell *cells = (Cell*) alloc_or_die((size_t) s.cpus * cols * sizeof(Cell));
+                long end = ftell(file);
+                fseek(file, offset, SEEK_SET);
+                fill_gantt(file, &s, cells, cols);
+                fseek(file, end, SEEK_SET);
+                print_gantt(&s, cells, cols);
+                free(cells);
+            }
+        }
+        free(s.busy);
+        free(s.cpu_switches);
+        free(s.last_pid);
+        if (!ok) {
+            printf("Log truncado ou inválido após %d simulações.\n", index);
+            break;
+        }
+    }
+    if (ok && index == 0) printf("O log não contém simulações.\n");
+    fclose(file);
+    return ok ? 0 : 1;
+}